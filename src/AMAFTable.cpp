@@ -0,0 +1,70 @@
+#include "AMAFTable.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+using index_t = AMAFTable::index_t;
+
+AMAFTable::AMAFTable(int maxActionCount) :
+	freeStatRanges(maxActionCount + 1) {
+
+}
+
+AMAFTable::NodeStats AMAFTable::allocate(index_t node, const MoveMask& legalMoves) {
+	if (node >= nodeSlots.size())
+		nodeSlots.resize(node + 1, NO_SLOT);
+	assert(nodeSlots[node] == NO_SLOT);
+
+	index_t slot = slots.size();
+	if (freeSlots.empty())
+		slots.emplace_back();
+	else {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	nodeSlots[node] = slot;
+
+	const int statCount = legalMoves.count();
+	auto& ranges = freeStatRanges[statCount];
+	index_t firstStat = stats.size();
+	if (ranges.empty())
+		stats.resize(stats.size() + statCount);
+	else {
+		firstStat = ranges.back();
+		ranges.pop_back();
+		std::fill_n(stats.begin() + firstStat, statCount, ActionStats());
+	}
+
+	slots[slot] = { legalMoves, firstStat, statCount };
+	return find(node);
+}
+
+void AMAFTable::release(index_t first, int count) {
+	const index_t end = std::min<index_t>(first + count, nodeSlots.size());
+	for (index_t i = first; i < end; ++i)
+		if (nodeSlots[i] != NO_SLOT) {
+			const auto& slot = slots[nodeSlots[i]];
+			freeStatRanges[slot.statCount].push_back(slot.firstStat);
+			freeSlots.push_back(nodeSlots[i]);
+			nodeSlots[i] = NO_SLOT;
+		}
+}
+
+/* slots of nodes dropped by compaction are freed, the others follow their node */
+void AMAFTable::remap(const std::vector<index_t>& newIndices, std::size_t nodeCount) {
+	std::vector<index_t> remappedSlots(nodeCount, NO_SLOT);
+	for (index_t i = 0; i < nodeSlots.size(); ++i) {
+		if (nodeSlots[i] == NO_SLOT)
+			continue;
+		if (newIndices[i] != NO_NODE)
+			remappedSlots[newIndices[i]] = nodeSlots[i];
+		else
+			release(i, 1);
+	}
+	nodeSlots.swap(remappedSlots);
+}
+
+std::size_t AMAFTable::getBytes() const {
+	return nodeSlots.capacity() * sizeof(index_t) + slots.capacity() * sizeof(Slot) +
+		stats.capacity() * sizeof(ActionStats);
+}
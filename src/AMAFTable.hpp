@@ -0,0 +1,84 @@
+#ifndef AMAF_TABLE_HPP
+#define AMAF_TABLE_HPP
+
+#include "Move.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * AMAF statistics of the RAVE agents, kept for a node only after it is
+ * allocated one and only for its legal moves. A node's slot holds its
+ * legal moves mask, the stats themselves are a range of the legal move
+ * count in one pool, in the order of the moves, so a move's stats are at
+ * its rank among the legal moves, counted in the mask. Ranges of the
+ * same length are reused. Rewards are sums of 0, 0.5 and 1,
+ * exact in a float far beyond the visit counts of a search.
+ */
+class AMAFTable {
+public:
+	using index_t = std::uint32_t;
+
+	struct ActionStats {
+		float reward = 0;
+		int visits = 0;
+	};
+
+	class NodeStats {
+	public:
+		NodeStats(ActionStats* stats, const MoveMask* legalMoves);
+
+		explicit operator bool() const;
+		/* nullptr for a move that is not legal in the node */
+		ActionStats* get(move_t move) const;
+
+	private:
+		ActionStats* stats;
+		const MoveMask* legalMoves;
+	};
+
+	AMAFTable(int maxActionCount);
+
+	NodeStats find(index_t node);
+	NodeStats allocate(index_t node, const MoveMask& legalMoves);
+	void release(index_t first, int count);
+	void remap(const std::vector<index_t>& newIndices, std::size_t nodeCount);
+	std::size_t getBytes() const;
+
+private:
+	static constexpr index_t NO_NODE = ~index_t(0);
+	static constexpr index_t NO_SLOT = ~index_t(0);
+
+	struct Slot {
+		MoveMask legalMoves;
+		index_t firstStat;
+		int statCount;
+	};
+
+	std::vector<index_t> nodeSlots;
+	std::vector<Slot> slots;
+	std::vector<index_t> freeSlots;
+	std::vector<ActionStats> stats;
+	std::vector<std::vector<index_t>> freeStatRanges;
+};
+
+inline AMAFTable::NodeStats::NodeStats(ActionStats* stats, const MoveMask* legalMoves) :
+	stats(stats), legalMoves(legalMoves) {
+}
+
+inline AMAFTable::NodeStats::operator bool() const {
+	return stats;
+}
+
+inline AMAFTable::ActionStats* AMAFTable::NodeStats::get(move_t move) const {
+	return legalMoves->test(move) ? stats + legalMoves->rank(move) : nullptr;
+}
+
+inline AMAFTable::NodeStats AMAFTable::find(index_t node) {
+	if (node >= nodeSlots.size() || nodeSlots[node] == NO_SLOT)
+		return { nullptr, nullptr };
+	const index_t slot = nodeSlots[node];
+	return { stats.data() + slots[slot].firstStat, &slots[slot].legalMoves };
+}
+
+#endif /* AMAF_TABLE_HPP */
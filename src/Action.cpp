@@ -1 +1,13 @@
 #include "Action.hpp"
+
+IndexAction::IndexAction(int idx) : idx(idx) {
+
+}
+
+bool IndexAction::equals(const sp<Action>& o) const {
+	return idx == o->getIdx();
+}
+
+int IndexAction::getIdx() const {
+	return idx;
+}
@@ -9,4 +9,14 @@ struct Action {
 	virtual ~Action() = default;
 };
 
+/* Action known only by its index, for states without a dedicated action type. */
+struct IndexAction : public Action {
+	explicit IndexAction(int idx);
+
+	bool equals(const sp<Action>& o) const override;
+	int getIdx() const override;
+
+	int idx;
+};
+
 #endif /* ACTION_HPP */
@@ -0,0 +1,117 @@
+#include "BitboardBatchRollout.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+using reward_t = BitboardBatchRollout::reward_t;
+
+void BitboardBatchRollout::run(const BitboardUltimateTicTacToe& state, int count, reward_t* rewards) {
+	PROFILE_FUNCTION();
+
+	assert(!state.isTerminal());
+	for (int done = 0; done < count; done += LANES)
+		runLanes(state.board, std::min(LANES, count - done), rewards + done);
+}
+
+const char* BitboardBatchRollout::getKernelName() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? "avx2" : "default";
+}
+
+void BitboardBatchRollout::runLanes(const Board& board, int count, reward_t* rewards) {
+	Lanes lanes;
+	for (int p = 0; p < 2; ++p) {
+		for (int b = 0; b < CELL_COUNT; ++b)
+			lanes.cells[p][b] = lane_t{} + std::int16_t(board.cells[p][b]);
+		lanes.won[p] = lane_t{} + std::int16_t(board.won[p]);
+		lanes.winnable[p] = lane_t{} + std::int16_t(board.winnable[p]);
+	}
+	lanes.decided = lane_t{} + std::int16_t(board.decided);
+	std::fill(lanes.nextBoard, lanes.nextBoard + LANES, board.nextBoard);
+
+	std::uint32_t active = (1u << count) - 1;
+	int turn = board.turn;
+	std::int8_t movedBoard[LANES] = {}, movedCell[LANES] = {};
+
+	while (active) {
+		lane_t changed {}, occupied {};
+		for (std::uint32_t left = active; left; left &= left - 1) {
+			const int l = __builtin_ctz(left);
+			int b, c;
+			pickMove(lanes, l, turn, b, c);
+			lanes.cells[turn][b][l] |= 1 << c;
+			changed[l] = lanes.cells[turn][b][l];
+			occupied[l] = changed[l] | lanes.cells[turn ^ 1][b][l];
+			movedBoard[l] = b, movedCell[l] = c;
+		}
+
+		lane_t smallWon {};
+		for (const std::int16_t line : SmallBoard::WIN_LINES)
+			smallWon |= (changed & line) == line;
+		const lane_t smallDecided = smallWon | (occupied == std::int16_t(FULL_MASK));
+
+		for (std::uint32_t left = active; left; left &= left - 1) {
+			const int l = __builtin_ctz(left);
+			const int b = movedBoard[l];
+			const std::int16_t boardBit = 1 << b;
+			lanes.decided[l] |= smallDecided[l] & boardBit;
+			lanes.won[turn][l] |= smallWon[l] & boardBit;
+			if (smallDecided[l])
+				lanes.winnable[AGENT1][l] &= ~boardBit, lanes.winnable[AGENT2][l] &= ~boardBit;
+			else if (!SmallBoard::isLineFree(lanes.cells[turn][b][l]))
+				lanes.winnable[turn ^ 1][l] &= ~boardBit;
+		}
+
+		lane_t macroWon {};
+		for (const std::int16_t line : SmallBoard::WIN_LINES)
+			macroWon |= (lanes.won[turn] & line) == line;
+		const lane_t macroFull = lanes.decided == std::int16_t(FULL_MASK);
+
+		lane_t open[2] = {};
+		for (int id = 0; id < 2; ++id) {
+			const lane_t reachable = lanes.won[id] | lanes.winnable[id];
+			for (const std::int16_t line : SmallBoard::WIN_LINES)
+				open[id] |= (reachable & line) == line;
+		}
+		const lane_t drawn = macroFull | ~(open[AGENT1] | open[AGENT2]);
+
+		for (std::uint32_t left = active; left; left &= left - 1) {
+			const int l = __builtin_ctz(left);
+			if (macroWon[l] | drawn[l]) {
+				rewards[l] = macroWon[l] ? (turn == AGENT1 ? 1 : 0) : 0.5;
+				active &= ~(1u << l);
+			}
+			else
+				lanes.nextBoard[l] = lanes.decided[l] & (1 << movedCell[l]) ? -1 : movedCell[l];
+		}
+
+		turn ^= 1;
+	}
+}
+
+void BitboardBatchRollout::pickMove(const Lanes& lanes, int lane, int turn, int& boardIdx, int& cellIdx) {
+	const int forced = lanes.nextBoard[lane];
+	auto getEmptyCells = [&](int b) -> const SmallBoard::MaskInfo& {
+		return SmallBoard::TABLES.info[lanes.cells[turn][b][lane] | lanes.cells[turn ^ 1][b][lane]];
+	};
+
+	if (forced != -1) {
+		const auto& empty = getEmptyCells(forced);
+		boardIdx = forced;
+		cellIdx = empty.emptyCells[Random::rand(int(empty.emptyCount))];
+		return;
+	}
+
+	int emptyCount[CELL_COUNT], total = 0;
+	const mask_t open = FULL_MASK & ~lanes.decided[lane];
+	for (int b = 0; b < CELL_COUNT; ++b)
+		total += emptyCount[b] = open & (1 << b) ? getEmptyCells(b).emptyCount : 0;
+	assert(total > 0);
+
+	int k = Random::rand(total);
+	int b = 0;
+	while (k >= emptyCount[b])
+		k -= emptyCount[b++];
+	boardIdx = b;
+	cellIdx = getEmptyCells(b).emptyCells[k];
+}
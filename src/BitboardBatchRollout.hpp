@@ -0,0 +1,50 @@
+#ifndef BITBOARD_BATCH_ROLLOUT_HPP
+#define BITBOARD_BATCH_ROLLOUT_HPP
+
+#include "BitboardUltimateTicTacToe.hpp"
+
+#include <cstdint>
+
+/*
+ * Random playouts of BitboardUltimateTicTacToe run in lockstep, LANES games
+ * at a time. The games start from the same position, so every lane has the
+ * same player to move on every ply. Moves are picked per lane (board by
+ * popcount of its empty cells, cell from the SmallBoard empty cell list),
+ * while small board and macro-board wins are tested for all lanes at once
+ * with vector compares. A lane stops early once neither player has an open
+ * macro line (a dead draw). The kernel is compiled twice, for AVX2 and for the
+ * baseline target, and the right clone is picked at load time.
+ */
+class BitboardBatchRollout {
+public:
+	using reward_t = State::reward_t;
+	using mask_t = BitboardUltimateTicTacToe::mask_t;
+
+	static constexpr int BOARD_SIZE = BitboardUltimateTicTacToe::BOARD_SIZE;
+	static constexpr int LANES = 16;
+
+	/* plays count random games from state and writes AGENT1 reward of every game */
+	static void run(const BitboardUltimateTicTacToe& state, int count, reward_t* rewards);
+	static const char* getKernelName();
+
+private:
+	using Board = BitboardUltimateTicTacToe::Board;
+	typedef std::int16_t lane_t __attribute__((vector_size(LANES * sizeof(std::int16_t))));
+
+	static constexpr int CELL_COUNT = BitboardUltimateTicTacToe::CELL_COUNT;
+	static constexpr mask_t FULL_MASK = BitboardUltimateTicTacToe::FULL_MASK;
+
+	struct Lanes {
+		lane_t cells[2][CELL_COUNT];
+		lane_t won[2];
+		lane_t decided;
+		lane_t winnable[2];
+		std::int8_t nextBoard[LANES];
+	};
+
+	__attribute__((target_clones("avx2", "default")))
+	static void runLanes(const Board& board, int count, reward_t* rewards);
+	static void pickMove(const Lanes& lanes, int lane, int turn, int& boardIdx, int& cellIdx);
+};
+
+#endif /* BITBOARD_BATCH_ROLLOUT_HPP */
@@ -0,0 +1,167 @@
+#include "BitboardUltimateTicTacToe.hpp"
+#include "BitboardBatchRollout.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+using reward_t = State::reward_t;
+using mask_t = SmallBoard::mask_t;
+
+template<int N>
+void BasicBitboardUltimateTicTacToe<N>::apply(const sp<Action>& act) {
+	PROFILE_FUNCTION();
+
+	apply(move_t(act->getIdx()));
+}
+
+template<int N>
+bool BasicBitboardUltimateTicTacToe<N>::isLegal(int boardIdx, int cellIdx) const {
+	if (board.terminal || boardIdx < 0 || boardIdx >= CELL_COUNT ||
+			cellIdx < 0 || cellIdx >= CELL_COUNT)
+		return false;
+	if (board.nextBoard != -1 && board.nextBoard != boardIdx)
+		return false;
+	if (board.decided & (1 << boardIdx))
+		return false;
+	return !((board.cells[AGENT1][boardIdx] | board.cells[AGENT2][boardIdx]) & (1 << cellIdx));
+}
+
+template<int N>
+std::vector<sp<Action>> BasicBitboardUltimateTicTacToe<N>::getValidActions() {
+	PROFILE_FUNCTION();
+
+	std::vector<sp<Action>> validActions;
+	if (board.terminal)
+		return validActions;
+
+	const mask_t boards = board.nextBoard == -1 ?
+		(FULL_MASK & ~board.decided) : mask_t(1 << board.nextBoard);
+	for (int b = 0; b < CELL_COUNT; ++b) {
+		if (!(boards & (1 << b)))
+			continue;
+		mask_t empty = SmallBoard::getEmptyMask<N>(board.cells[AGENT1][b], board.cells[AGENT2][b]);
+		for (; empty; empty &= empty - 1)
+			validActions.push_back(std::mksh<action_t>(getActionIdx(b, __builtin_ctz(empty))));
+	}
+
+	return validActions;
+}
+
+template<int N>
+bool BasicBitboardUltimateTicTacToe<N>::isValid(const sp<Action>& act) const {
+	const int actionIdx = act->getIdx();
+	return isLegal(getBoardIdx(actionIdx), getCellIdx(actionIdx));
+}
+
+template<int N>
+bool BasicBitboardUltimateTicTacToe<N>::isValid(move_t move) const {
+	return isLegal(getBoardIdx(move), getCellIdx(move));
+}
+
+template<int N>
+sp<Action> BasicBitboardUltimateTicTacToe<N>::makeAction(move_t move) const {
+	return std::mksh<action_t>(move);
+}
+
+template<int N>
+up<State> BasicBitboardUltimateTicTacToe<N>::clone() {
+	return up<State>(new BasicBitboardUltimateTicTacToe(*this));
+}
+
+template<int N>
+bool BasicBitboardUltimateTicTacToe<N>::didWin(AgentID id) {
+	return board.terminal && id == getWinner();
+}
+
+template<int N>
+void BasicBitboardUltimateTicTacToe<N>::randomPlayouts(int count, reward_t* rewardSums) {
+	PROFILE_FUNCTION();
+
+	if constexpr (N != BitboardBatchRollout::BOARD_SIZE)
+		State::randomPlayouts(count, rewardSums);
+	else {
+		reward_t rewards[BitboardBatchRollout::LANES];
+		for (int done = 0; done < count; done += BitboardBatchRollout::LANES) {
+			const int batch = std::min(BitboardBatchRollout::LANES, count - done);
+			BitboardBatchRollout::run(*this, batch, rewards);
+			for (int i = 0; i < batch; ++i) {
+				rewardSums[AGENT1] += rewards[i];
+				rewardSums[AGENT2] += 1 - rewards[i];
+			}
+		}
+	}
+}
+
+template<int N>
+std::ostream& BasicBitboardUltimateTicTacToe<N>::print(std::ostream& out) const {
+	std::string smallSep;
+	for (int j = 0; j < BOARD_SIZE; ++j)
+		smallSep += "+---";
+	smallSep += "+ ";
+
+	for (int i = 0; i < BOARD_SIZE; ++i) {
+		printLineSep(out);
+		for (int row = 0; row < BOARD_SIZE; ++row) {
+			for (int j = 0; j < BOARD_SIZE; ++j)
+				out << "| " << smallSep;
+			out << "|\n";
+			for (int j = 0; j < BOARD_SIZE; ++j) {
+				out << "| ";
+				for (int col = 0; col < BOARD_SIZE; ++col)
+					out << "| " << getCharAt(i * BOARD_SIZE + j, row, col) << " ";
+				out << "| ";
+			}
+			out << "|\n";
+		}
+		for (int j = 0; j < BOARD_SIZE; ++j)
+			out << "| " << smallSep;
+		out << "|\n";
+	}
+	printLineSep(out);
+	return out;
+}
+
+template<int N>
+void BasicBitboardUltimateTicTacToe<N>::printLineSep(std::ostream& out) const {
+	std::string sep((4 * BOARD_SIZE + 1) + 2, '-');
+	for (int j = 0; j < BOARD_SIZE; ++j)
+		out << '+' << sep;
+	out << "+\n";
+}
+
+template<int N>
+char BasicBitboardUltimateTicTacToe<N>::getCharAt(int boardIdx, int row, int col) const {
+	const mask_t bit = 1 << (row * BOARD_SIZE + col);
+	const mask_t boardBit = 1 << boardIdx;
+
+	if (board.won[AGENT1] & boardBit)
+		return row == col || row + col == BOARD_SIZE - 1 ? 'X' : ' ';
+	if (board.won[AGENT2] & boardBit)
+		return col == 0 || col == BOARD_SIZE - 1 ||
+			row == 0 || row == BOARD_SIZE - 1 ? 'O' : ' ';
+	if (board.cells[AGENT1][boardIdx] & bit)
+		return 'X';
+	if (board.cells[AGENT2][boardIdx] & bit)
+		return 'O';
+	return ' ';
+}
+
+template<int N>
+std::string BasicBitboardUltimateTicTacToe<N>::getWinnerName() {
+	PROFILE_FUNCTION();
+
+	assert(isTerminal());
+	const auto winner = getWinner();
+	switch (winner) {
+		case AGENT1:
+			return "AGENT1 / Player X";
+		case AGENT2:
+			return "AGENT2 / Player O";
+		case NONE:
+			return "";
+	}
+	assert(false);
+}
+
+template class BasicBitboardUltimateTicTacToe<3>;
+template class BasicBitboardUltimateTicTacToe<4>;
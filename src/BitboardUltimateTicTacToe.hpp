@@ -0,0 +1,270 @@
+#ifndef BITBOARD_ULTIMATE_TICTACTOE_HPP
+#define BITBOARD_ULTIMATE_TICTACTOE_HPP
+
+#include "Common.hpp"
+#include "Action.hpp"
+#include "State.hpp"
+#include "UltimateTicTacToe.hpp"
+#include "SmallBoardTables.hpp"
+#include "Zobrist.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+/*
+ * UltimateTicTacToe with every small board kept as two occupancy masks.
+ * Wins are found with the SmallBoard win lines, the macro-board is tracked
+ * with masks as well, so the whole position is a small trivially copyable
+ * struct and clone() is a plain copy. Boards each player can still win are
+ * tracked too, so a position where no macro line can be completed any more
+ * is known to be a draw before the board fills up.
+ *
+ * N is the size of both the macro-board and the small boards (N x N boards
+ * of N x N cells), so all the index math and win lines are compile-time
+ * constants. Definitions live in the .cpp file and are instantiated there
+ * for the supported sizes. Actions index cells row by row over the whole
+ * N^2 x N^2 grid, N = 3 keeps UltimateTicTacToe actions for compatibility
+ * with the runners.
+ */
+template<int N>
+class BasicBitboardUltimateTicTacToe final : public State {
+public:
+	using reward_t = State::reward_t;
+	using action_t = std::conditional_t<N == UltimateTicTacToe::BOARD_SIZE,
+		UltimateTicTacToe::action_t, IndexAction>;
+	using mask_t = SmallBoard::mask_t;
+
+	bool isTerminal() const override;
+	bool isDecided() const override;
+	void apply(const sp<Action>& act) override;
+	void apply(move_t move) override;
+	undo_t getUndoInfo() const override;
+	void undo(move_t move, undo_t undoInfo) override;
+
+	constexpr int getAgentCount() const override { return 2; }
+	constexpr int getActionCount() const override { return MAX_MOVES; }
+
+	std::vector<sp<Action>> getValidActions() override;
+	bool isValid(const sp<Action>& act) const override;
+	bool isValid(move_t move) const override;
+
+	MoveMask getValidMovesMask() const override;
+	sp<Action> makeAction(move_t move) const override;
+
+	up<State> clone() override;
+	bool didWin(AgentID id) override;
+	reward_t getReward(AgentID id) override;
+	AgentID getTurn() const override;
+	std::uint64_t hash() const override;
+	void randomPlayouts(int count, reward_t* rewardSums) override;
+
+	std::ostream& print(std::ostream& out) const override;
+	std::string getWinnerName() override;
+
+	static constexpr int BOARD_SIZE = N;
+	static constexpr int CELL_COUNT = BOARD_SIZE * BOARD_SIZE;
+	static constexpr mask_t FULL_MASK = SmallBoard::getFullMask<N>();
+	static constexpr int MAX_MOVES = CELL_COUNT * CELL_COUNT;
+	static_assert(MAX_MOVES <= MAX_MOVE_COUNT, "Moves have to fit in move_t");
+	static_assert(CELL_COUNT <= Zobrist::MAX_FORCED_BOARDS, "Too many boards for Zobrist keys");
+
+private:
+	friend class BitboardBatchRollout;
+
+	struct Board {
+		mask_t cells[2][CELL_COUNT];
+		mask_t won[2];
+		mask_t decided;
+		/* undecided boards that a player can still win */
+		mask_t winnable[2];
+		std::int8_t nextBoard;
+		std::int8_t turn;
+		std::int8_t winner;
+		bool terminal;
+		Zobrist::hash_t hash;
+	};
+	static_assert(std::is_trivially_copyable<Board>::value,
+		"Board has to be trivially copyable");
+
+	static constexpr int getBoardIdx(int actionIdx);
+	static constexpr int getCellIdx(int actionIdx);
+	static constexpr int getActionIdx(int boardIdx, int cellIdx);
+
+	bool isLegal(int boardIdx, int cellIdx) const;
+	void applyAt(int boardIdx, int cellIdx);
+	void updateWinnable(int boardIdx);
+	AgentID getWinner() const;
+
+	void printLineSep(std::ostream& out) const;
+	char getCharAt(int boardIdx, int row, int col) const;
+
+private:
+	Board board { {}, {}, 0, { FULL_MASK, FULL_MASK }, -1, AGENT1, NONE, false, Zobrist::getInitialHash() };
+};
+
+/*
+ * The playout and search hot path is defined here, so that code holding the
+ * concrete type (MCTS<game_t>, the batch kernel) can inline it.
+ */
+template<int N>
+inline bool BasicBitboardUltimateTicTacToe<N>::isTerminal() const {
+	return board.terminal;
+}
+
+/* a macro line is still open for a player if all its boards are won or winnable by them */
+template<int N>
+inline bool BasicBitboardUltimateTicTacToe<N>::isDecided() const {
+	return board.terminal ||
+		(!SmallBoard::isLine<N>(board.won[AGENT1] | board.winnable[AGENT1]) &&
+		 !SmallBoard::isLine<N>(board.won[AGENT2] | board.winnable[AGENT2]));
+}
+
+/* a grid row has CELL_COUNT cells, a row of small boards BOARD_SIZE grid rows */
+template<int N>
+constexpr int BasicBitboardUltimateTicTacToe<N>::getBoardIdx(int actionIdx) {
+	constexpr int rowSize = CELL_COUNT * BOARD_SIZE;
+	return (actionIdx / rowSize) * BOARD_SIZE + (actionIdx % CELL_COUNT) / BOARD_SIZE;
+}
+
+template<int N>
+constexpr int BasicBitboardUltimateTicTacToe<N>::getCellIdx(int actionIdx) {
+	return ((actionIdx / CELL_COUNT) % BOARD_SIZE) * BOARD_SIZE + actionIdx % BOARD_SIZE;
+}
+
+template<int N>
+constexpr int BasicBitboardUltimateTicTacToe<N>::getActionIdx(int boardIdx, int cellIdx) {
+	const int row = (boardIdx / BOARD_SIZE) * BOARD_SIZE + cellIdx / BOARD_SIZE;
+	const int col = (boardIdx % BOARD_SIZE) * BOARD_SIZE + cellIdx % BOARD_SIZE;
+	return row * CELL_COUNT + col;
+}
+
+template<int N>
+inline void BasicBitboardUltimateTicTacToe<N>::apply(move_t move) {
+	PROFILE_FUNCTION();
+
+	board.hash ^= Zobrist::KEYS.cells[board.turn][move] ^ Zobrist::KEYS.turn ^
+		Zobrist::getForcedBoardKey(board.nextBoard);
+	applyAt(getBoardIdx(move), getCellIdx(move));
+	board.hash ^= Zobrist::getForcedBoardKey(board.nextBoard);
+}
+
+template<int N>
+inline void BasicBitboardUltimateTicTacToe<N>::applyAt(int boardIdx, int cellIdx) {
+	assert(isLegal(boardIdx, cellIdx));
+
+	const int turn = board.turn;
+	const mask_t boardBit = 1 << boardIdx;
+	auto& cells = board.cells[turn][boardIdx];
+	cells |= 1 << cellIdx;
+
+	if (SmallBoard::isLine<N>(cells)) {
+		board.won[turn] |= boardBit;
+		board.decided |= boardBit;
+		if (SmallBoard::isLine<N>(board.won[turn]))
+			board.terminal = true, board.winner = turn;
+	}
+	else if ((cells | board.cells[turn ^ 1][boardIdx]) == FULL_MASK)
+		board.decided |= boardBit;
+
+	if (board.decided == FULL_MASK)
+		board.terminal = true;
+	updateWinnable(boardIdx);
+
+	board.nextBoard = board.decided & (1 << cellIdx) ? -1 : cellIdx;
+	board.turn = turn ^ 1;
+}
+
+template<int N>
+inline void BasicBitboardUltimateTicTacToe<N>::updateWinnable(int boardIdx) {
+	const mask_t boardBit = 1 << boardIdx;
+	for (int id = 0; id < 2; ++id) {
+		board.winnable[id] &= ~boardBit;
+		if (!(board.decided & boardBit) && SmallBoard::isLineFree<N>(board.cells[id ^ 1][boardIdx]))
+			board.winnable[id] |= boardBit;
+	}
+}
+
+/* the board the next move is forced to, -1 for any */
+template<int N>
+inline undo_t BasicBitboardUltimateTicTacToe<N>::getUndoInfo() const {
+	return board.nextBoard;
+}
+
+template<int N>
+inline void BasicBitboardUltimateTicTacToe<N>::undo(move_t move, undo_t undoInfo) {
+	PROFILE_FUNCTION();
+
+	const int boardIdx = getBoardIdx(move), cellIdx = getCellIdx(move);
+	const int turn = board.turn ^ 1;
+	const mask_t boardBit = 1 << boardIdx;
+	assert(board.cells[turn][boardIdx] & (1 << cellIdx));
+
+	board.cells[turn][boardIdx] &= ~(1 << cellIdx);
+	board.won[turn] &= ~boardBit;
+	board.decided &= ~boardBit;
+	board.terminal = false;
+	board.winner = NONE;
+	board.hash ^= Zobrist::KEYS.cells[turn][move] ^ Zobrist::KEYS.turn ^
+		Zobrist::getForcedBoardKey(board.nextBoard);
+	board.nextBoard = undoInfo;
+	board.hash ^= Zobrist::getForcedBoardKey(board.nextBoard);
+	board.turn = turn;
+	updateWinnable(boardIdx);
+}
+
+template<int N>
+inline MoveMask BasicBitboardUltimateTicTacToe<N>::getValidMovesMask() const {
+	PROFILE_FUNCTION();
+
+	MoveMask validMoves;
+	if (board.terminal)
+		return validMoves;
+
+	constexpr mask_t rowMask = (1 << BOARD_SIZE) - 1;
+	const mask_t boards = board.nextBoard == -1 ?
+		(FULL_MASK & ~board.decided) : mask_t(1 << board.nextBoard);
+	for (int b = 0; b < CELL_COUNT; ++b) {
+		if (!(boards & (1 << b)))
+			continue;
+		const mask_t empty = SmallBoard::getEmptyMask<N>(board.cells[AGENT1][b], board.cells[AGENT2][b]);
+		const int offset = (b / BOARD_SIZE) * BOARD_SIZE * CELL_COUNT + (b % BOARD_SIZE) * BOARD_SIZE;
+		for (int r = 0; r < BOARD_SIZE; ++r)
+			validMoves.setBits(offset + r * CELL_COUNT, (empty >> (r * BOARD_SIZE)) & rowMask);
+	}
+
+	return validMoves;
+}
+
+template<int N>
+inline State::reward_t BasicBitboardUltimateTicTacToe<N>::getReward(AgentID id) {
+	assert(isDecided());
+	auto winner = board.terminal ? getWinner() : NONE;
+	if (winner == NONE)
+		return 0.5;
+	return id == winner ? 1 : 0;
+}
+
+template<int N>
+inline AgentID BasicBitboardUltimateTicTacToe<N>::getWinner() const {
+	assert(board.terminal);
+	return AgentID(board.winner);
+}
+
+template<int N>
+inline AgentID BasicBitboardUltimateTicTacToe<N>::getTurn() const {
+	return AgentID(board.turn);
+}
+
+template<int N>
+inline std::uint64_t BasicBitboardUltimateTicTacToe<N>::hash() const {
+	return board.hash;
+}
+
+extern template class BasicBitboardUltimateTicTacToe<3>;
+extern template class BasicBitboardUltimateTicTacToe<4>;
+
+using BitboardUltimateTicTacToe = BasicBitboardUltimateTicTacToe<3>;
+using Bitboard4UltimateTicTacToe = BasicBitboardUltimateTicTacToe<4>;
+
+#endif /* BITBOARD_ULTIMATE_TICTACTOE_HPP */
@@ -8,8 +8,27 @@ void errorExit(const std::string& msg) {
 	exit(EXIT_FAILURE);
 }
 
-namespace Random {
-	std::mt19937 rng(std::random_device{}());
+void Random::Xoshiro256::jump() {
+	static constexpr std::uint64_t JUMP[] = {
+		0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+	};
+
+	std::uint64_t jumped[4] = {};
+	for (const auto word : JUMP)
+		for (int bit = 0; bit < 64; ++bit) {
+			if (word & (1ULL << bit))
+				for (int i = 0; i < 4; ++i)
+					jumped[i] ^= state[i];
+			(*this)();
+		}
+	for (int i = 0; i < 4; ++i)
+		state[i] = jumped[i];
+}
+
+void Random::seed(std::uint64_t seed, int stream) {
+	rng.seed(seed);
+	for (int i = 0; i < stream; ++i)
+		rng.jump();
 }
 
 int SimpleTimer::instanceCounter = 0;
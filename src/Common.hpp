@@ -2,9 +2,12 @@
 #define COMMON_HPP
 
 #include <iostream>
+#include <cassert>
+#include <cstdint>
 #include <memory>
 #include <random>
 #include <chrono>
+#include <type_traits>
 
 #define mksh make_shared
 #define mku make_unique
@@ -21,28 +24,120 @@ using KeyValue = std::pair<std::string, std::string>;
 void errorExit(const std::string& msg);
 
 namespace Random {
-	extern std::mt19937 rng;
+	constexpr std::uint64_t splitMix64(std::uint64_t& seed) {
+		std::uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	/*
+	 * xoshiro256** generator: 32 bytes of state and a few cycles per number.
+	 * Meets UniformRandomBitGenerator, so it can be passed to std::shuffle.
+	 */
+	class Xoshiro256 {
+	public:
+		using result_type = std::uint64_t;
+
+		constexpr explicit Xoshiro256(std::uint64_t seed) : state() {
+			this->seed(seed);
+		}
+
+		constexpr void seed(std::uint64_t seed) {
+			for (auto& word : state)
+				word = splitMix64(seed);
+		}
+
+		constexpr result_type operator()() {
+			const auto result = rotl(state[1] * 5, 7) * 9;
+			const auto t = state[1] << 17;
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = rotl(state[3], 45);
+			return result;
+		}
+
+		/* advances by 2^128 numbers, streams made by jumping never overlap */
+		void jump();
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return ~result_type(0); }
+
+	private:
+		static constexpr std::uint64_t rotl(std::uint64_t x, int k) {
+			return (x << k) | (x >> (64 - k));
+		}
+
+		std::uint64_t state[4];
+	};
+
+	using generator_t = Xoshiro256;
+	constexpr std::uint64_t DEFAULT_SEED = 0x5eedULL;
+
+	/* generator of the calling thread, every thread starts from DEFAULT_SEED */
+	inline thread_local generator_t rng { DEFAULT_SEED };
+
+	/* reseeds the calling thread, stream k is the seeded generator jumped k times */
+	void seed(std::uint64_t seed, int stream=0);
+
+	/* uniform in [0, n) without modulo bias (Lemire's multiply-shift with rejection) */
+	inline std::uint32_t bounded(std::uint32_t n) {
+		assert(n > 0);
+		std::uint64_t product = (rng() >> 32) * n;
+		if (std::uint32_t(product) < n) {
+			const std::uint32_t threshold = -n % n;
+			while (std::uint32_t(product) < threshold)
+				product = (rng() >> 32) * n;
+		}
+		return std::uint32_t(product >> 32);
+	}
+
+	/* bounded for 64-bit ranges, n = 0 stands for all 2^64 values */
+	inline std::uint64_t bounded64(std::uint64_t n) {
+		if (n == 0)
+			return rng();
+		unsigned __int128 product = static_cast<unsigned __int128>(rng()) * n;
+		if (std::uint64_t(product) < n) {
+			const std::uint64_t threshold = -n % n;
+			while (std::uint64_t(product) < threshold)
+				product = static_cast<unsigned __int128>(rng()) * n;
+		}
+		return std::uint64_t(product >> 64);
+	}
+
+	/* uniform in [0, 1) */
+	inline double unit() {
+		return (rng() >> 11) * 0x1.0p-53;
+	}
 
+	/* uniform in [a, b], integral ranges wider than 32 bits and the full range of T included */
 	template<typename T>
 	T rand(T a, T b) {
-		using dist_t = std::conditional_t<
-			std::is_integral<T>::value,
-			std::uniform_int_distribution<T>,
-			std::uniform_real_distribution<T>
-		>;
-		return dist_t{a, b}(rng);
+		if constexpr (std::is_integral<T>::value) {
+			using unsigned_t = std::make_unsigned_t<T>;
+			const std::uint64_t span = unsigned_t(unsigned_t(b) - unsigned_t(a));
+			const std::uint64_t offset = span < UINT32_MAX ?
+				bounded(std::uint32_t(span) + 1) : bounded64(span + 1);
+			return T(unsigned_t(unsigned_t(a) + offset));
+		}
+		else
+			return a + T((b - a) * unit());
 	}
 
 	template<typename T>
 	T rand(T n) {
-		using dist_t = std::conditional_t<
-			std::is_integral<T>::value,
-			std::uniform_int_distribution<T>,
-			std::uniform_real_distribution<T>
-		>;
-		if (std::is_integral<T>::value)
-			--n;
-		return dist_t{0, n}(rng);
+		if constexpr (std::is_integral<T>::value) {
+			assert(n > 0);
+			if constexpr (sizeof(T) > sizeof(std::uint32_t))
+				return T(bounded64(n));
+			else
+				return T(bounded(std::uint32_t(n)));
+		}
+		else
+			return T(n * unit());
 	}
 
 	template<typename T, typename Alloc, template<typename, typename> class Container>
@@ -8,43 +8,93 @@
 using ActionStats = FlatMCTSAgent::ActionStats;
 using reward_t = FlatMCTSAgent::reward_t;
 
-FlatMCTSAgent::FlatMCTSAgent(AgentID id, double calcLimitInMs, const up<State>&, const AgentArgs&) : 
-	Agent(id, calcLimitInMs) {
+FlatMCTSAgent::FlatMCTSAgent(AgentID id, double calcLimitInMs,
+		const up<State>& initialState, const AgentArgs& args) :
+	Agent(id, calcLimitInMs),
+	undoSearch(getOrDefault(args, "undoSearch", 0)),
+	batchPlayouts(getOrDefault(args, "batchPlayouts", 1)),
+	batchRewards(initialState->getAgentCount()) {
 
+	playedMoves.reserve(initialState->getActionCount());
 }
 
 sp<Action> FlatMCTSAgent::getAction(const up<State>& state) {
 	timer.startCalculation();
 
-	auto validActions = state->getValidActions();
-	assert(!validActions.empty());
+	state->getValidMoves(validMoves);
+	assert(!validMoves.empty());
 
-	int actionsNum = static_cast<int>(validActions.size());
+	int actionsNum = validMoves.size();
 	stats.resize(actionsNum);
 	std::fill(stats.begin(), stats.end(), ActionStats());
 	
+	auto searchState = undoSearch ? state->clone() : up<State>();
 	while (timer.isTimeLeft()) {
 		int randActionIdx = Random::rand(actionsNum);
-		auto nState = state->applyCopy(validActions[randActionIdx]);
-
-		while (!nState->isTerminal()) {
-			auto actions = nState->getValidActions();
-			const auto& action = Random::choice(actions);
-			nState->apply(action);
+		if (batchPlayouts > 1) {
+			simulateBatch(state, randActionIdx);
+			simulationCount += batchPlayouts;
+			continue;
 		}
-
-		++stats[randActionIdx].total;
-		stats[randActionIdx].reward += nState->getReward(getID());
+		if (undoSearch)
+			simulateWithUndo(*searchState, randActionIdx);
+		else
+			simulateWithClone(state, randActionIdx);
 		++simulationCount;
 	}
 
 	int bestIdx = std::max_element(stats.begin(), stats.end()) - stats.begin();
-	const auto& bestAction = validActions[bestIdx];
+	const auto bestAction = state->makeAction(validMoves[bestIdx]);
 	timer.stopCalculation();
 
 	return bestAction;
 }
 
+void FlatMCTSAgent::simulateWithClone(const up<State>& state, int moveIdx) {
+	auto nState = state->applyCopy(validMoves[moveIdx]);
+
+	while (!nState->isDecided())
+		nState->apply(Random::choice(nState->getValidMovesMask()));
+
+	++stats[moveIdx].total;
+	stats[moveIdx].reward += nState->getReward(getID());
+}
+
+void FlatMCTSAgent::simulateWithUndo(State& searchState, int moveIdx) {
+	playedMoves.push_back({ validMoves[moveIdx], searchState.getUndoInfo() });
+	searchState.apply(validMoves[moveIdx]);
+
+	while (!searchState.isDecided()) {
+		const auto move = Random::choice(searchState.getValidMovesMask());
+		playedMoves.push_back({ move, searchState.getUndoInfo() });
+		searchState.apply(move);
+	}
+
+	++stats[moveIdx].total;
+	stats[moveIdx].reward += searchState.getReward(getID());
+
+	while (!playedMoves.empty()) {
+		searchState.undo(playedMoves.back().move, playedMoves.back().undoInfo);
+		playedMoves.pop_back();
+	}
+}
+
+void FlatMCTSAgent::simulateBatch(const up<State>& state, int moveIdx) {
+	auto nState = state->applyCopy(validMoves[moveIdx]);
+
+	reward_t reward;
+	if (nState->isDecided())
+		reward = batchPlayouts * nState->getReward(getID());
+	else {
+		std::fill(batchRewards.begin(), batchRewards.end(), 0);
+		nState->randomPlayouts(batchPlayouts, batchRewards.data());
+		reward = batchRewards[getID()];
+	}
+
+	stats[moveIdx].total += batchPlayouts;
+	stats[moveIdx].reward += reward;
+}
+
 bool ActionStats::operator<(const ActionStats& o) const {
 	return reward * o.total < o.reward * total;
 }
@@ -23,8 +23,21 @@ public:
 		bool operator<(const ActionStats& o) const;
 	};
 
+private:
+	void simulateWithClone(const up<State>& state, int moveIdx);
+	void simulateWithUndo(State& searchState, int moveIdx);
+	void simulateBatch(const up<State>& state, int moveIdx);
+
 private:
 	std::vector<ActionStats> stats;
+	MoveList validMoves;
+
+	bool undoSearch;
+	std::vector<PlayedMove> playedMoves;
+
+	/* random playouts run at once after a root move (State::randomPlayouts) */
+	int batchPlayouts;
+	std::vector<reward_t> batchRewards;
 };
 
 #endif /* MCTS_AGENT_HPP */
@@ -18,9 +18,16 @@ public:
 		
 	}
 
+	/* game k of the following playGames runs on Random stream k of seed */
+	void setSeed(std::uint64_t seed) {
+		this->seed = seed;
+		seeded = true;
+	}
+
 	void playGames(int numberOfGames, bool verbose=false) {
 		this->numberOfGames = numberOfGames;
 		statSystem.reset();
+		gameIdx = 0;
 		for (int i = 0; i < numberOfGames - 1; ++i)
 			playGame(verbose);
 		playGame(verbose, true);
@@ -29,6 +36,9 @@ public:
 
 	void playGame(bool verbose=false, bool lastGame=false) {
 		announceGameStart();
+		if (seeded)
+			Random::seed(seed, gameIdx);
+		++gameIdx;
 
 		up<State> game = std::mku<game_t>();
 		sp<Agent> agents[] {
@@ -83,6 +93,10 @@ private:
 	StatSystem statSystem;
 	int numberOfGames;
 	std::vector<int> agentSimCount;
+
+	bool seeded = false;
+	std::uint64_t seed = 0;
+	int gameIdx = 0;
 };
 
 #endif /* GAME_RUNNER_HPP */
@@ -0,0 +1,71 @@
+#include "MASTPolicy.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+MASTPolicy::MASTPolicy(const Agent& agent, const up<State>& initialState, const AgentArgs& args) :
+	epsilon(agent.getOrDefault(args, "epsilon", 0.8)),
+	decayFactor(agent.getOrDefault(args, "decayFactor", 0.6)),
+	actionsStats(std::mksh<MASTTable>(initialState->getAgentCount(), initialState->getActionCount())),
+	pendingUpdates(*actionsStats),
+	flushInterval(std::max(1, int(agent.getOrDefault(args, "mastFlushInterval", 1)))) {
+
+}
+
+void MASTPolicy::share(MASTPolicy& worker) const {
+	actionsStats->share();
+	worker.actionsStats = actionsStats;
+	worker.decaysTable = false;
+}
+
+move_t MASTPolicy::getMove(const State& state) const {
+	const auto moves = state.getValidMovesMask();
+	assert(!moves.empty());
+
+	if (Random::rand(1.0) <= epsilon)
+		return Random::choice(moves);
+
+	const auto& stats = *actionsStats;
+	const AgentID turn = AgentID(state.getTurn());
+	move_t bestMove = *moves.begin();
+	auto s1 = stats.get(turn, bestMove);
+	for (const auto move : moves) {
+		const auto s2 = stats.get(turn, move);
+		if (s1.score * s2.times < s2.score * s1.times)
+			bestMove = move, s1 = s2;
+	}
+	return bestMove;
+}
+
+void MASTPolicy::record(AgentID id, int actionIdx) {
+	actionHistory.emplace_back(id, actionIdx);
+}
+
+const std::vector<std::pair<AgentID, int>>& MASTPolicy::getHistory() const {
+	return actionHistory;
+}
+
+void MASTPolicy::endPlayout(const std::vector<reward_t>& agentRewards) {
+	for (const auto& [agentID, actionIdx] : actionHistory)
+		pendingUpdates.add(agentID, actionIdx, agentRewards[agentID]);
+	actionHistory.clear();
+	if (++pendingPlayouts == flushInterval) {
+		actionsStats->flush(pendingUpdates);
+		pendingPlayouts = 0;
+	}
+}
+
+void MASTPolicy::endSearch() {
+	actionsStats->flush(pendingUpdates);
+	pendingPlayouts = 0;
+	if (decaysTable)
+		actionsStats->decay(decayFactor);
+}
+
+void MASTPolicy::appendDesc(std::vector<KeyValue>& desc) const {
+	desc.insert(desc.end(), {
+		{ "Epsilon constant (E) in MAST default policy", std::to_string(epsilon) },
+		{ "Decay factor (gamma) in MAST global action table", std::to_string(decayFactor) },
+		{ "Playouts between MAST table updates", std::to_string(flushInterval) },
+	});
+}
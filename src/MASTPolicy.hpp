@@ -0,0 +1,54 @@
+#ifndef MAST_POLICY_HPP
+#define MAST_POLICY_HPP
+
+#include "Common.hpp"
+#include "Agent.hpp"
+#include "State.hpp"
+#include "Move.hpp"
+#include "MASTTable.hpp"
+
+#include <utility>
+#include <vector>
+
+/*
+ * The MAST default policy of the MAST agents. Playout moves are chosen
+ * epsilon-greedy by the averages of a MASTTable, which every playout
+ * updates with the moves recorded for it, tree and playout moves alike.
+ * The table is shared with the workers of a root-parallel search. Every
+ * thread adds its playouts to it every mastFlushInterval playouts and in
+ * endSearch, the agent that created it decays it after the workers are
+ * done. The agent plays its playouts through getMove one at a time.
+ */
+class MASTPolicy {
+public:
+	using param_t = Agent::param_t;
+	using reward_t = State::reward_t;
+	using AgentArgs = Agent::AgentArgs;
+
+	/* the parameters are read from args as agent reads them */
+	MASTPolicy(const Agent& agent, const up<State>& initialState, const AgentArgs& args);
+
+	/* makes worker update the table of this policy instead of its own */
+	void share(MASTPolicy& worker) const;
+
+	move_t getMove(const State& state) const;
+	void record(AgentID id, int actionIdx);
+	const std::vector<std::pair<AgentID, int>>& getHistory() const;
+	/* adds the recorded moves with the rewards of the playout and starts a new history */
+	void endPlayout(const std::vector<reward_t>& agentRewards);
+	void endSearch();
+
+	void appendDesc(std::vector<KeyValue>& desc) const;
+
+private:
+	param_t epsilon;
+	param_t decayFactor;
+	sp<MASTTable> actionsStats;
+	MASTTable::Updates pendingUpdates;
+	int flushInterval;
+	int pendingPlayouts = 0;
+	bool decaysTable = true;
+	std::vector<std::pair<AgentID, int>> actionHistory;
+};
+
+#endif /* MAST_POLICY_HPP */
@@ -0,0 +1,67 @@
+#include "MASTTable.hpp"
+
+#include <cassert>
+#include <cmath>
+
+using reward_t = MASTTable::reward_t;
+
+MASTTable::Updates::Updates(const MASTTable& table) :
+	actionCount(table.actionCount),
+	scores(table.entryCount),
+	times(table.entryCount) {
+
+}
+
+void MASTTable::Updates::add(AgentID id, int actionIdx, reward_t reward) {
+	const int idx = id * actionCount + actionIdx;
+	assert(idx < int(scores.size()));
+	if (times[idx]++ == 0)
+		touched.push_back(idx);
+	scores[idx] += reward;
+}
+
+MASTTable::MASTTable(int agentCount, int actionCount) :
+	actionCount(actionCount),
+	entryCount(agentCount * actionCount),
+	entries(new Entry[entryCount]()) {
+
+}
+
+MASTTable::ActionStats MASTTable::get(AgentID id, int actionIdx) const {
+	const auto& entry = entries[id * actionCount + actionIdx];
+	return { entry.score.load(std::memory_order_relaxed) / SCORE_UNIT,
+		entry.times.load(std::memory_order_relaxed) };
+}
+
+void MASTTable::flush(Updates& updates) {
+	for (const int idx : updates.touched) {
+		auto& entry = entries[idx];
+		const std::int64_t score = toFixed(updates.scores[idx]);
+		if (shared) {
+			entry.score.fetch_add(score, std::memory_order_relaxed);
+			entry.times.fetch_add(updates.times[idx], std::memory_order_relaxed);
+		}
+		else {
+			entry.score.store(entry.score.load(std::memory_order_relaxed) + score, std::memory_order_relaxed);
+			entry.times.store(entry.times.load(std::memory_order_relaxed) + updates.times[idx],
+				std::memory_order_relaxed);
+		}
+		updates.scores[idx] = updates.times[idx] = 0;
+	}
+	updates.touched.clear();
+}
+
+void MASTTable::share() {
+	shared = true;
+}
+
+void MASTTable::decay(reward_t factor) {
+	for (int i = 0; i < entryCount; ++i) {
+		auto& score = entries[i].score;
+		score.store(std::llround(score.load(std::memory_order_relaxed) * factor), std::memory_order_relaxed);
+	}
+}
+
+std::int64_t MASTTable::toFixed(reward_t reward) {
+	return std::int64_t(reward * SCORE_UNIT + 0.5);
+}
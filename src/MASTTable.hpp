@@ -0,0 +1,75 @@
+#ifndef MAST_TABLE_HPP
+#define MAST_TABLE_HPP
+
+#include "Common.hpp"
+#include "State.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * MAST statistics of the actions of every agent, shared by the threads of
+ * a root-parallel search and updated without locks. Scores are fixed
+ * point sums in 1 / SCORE_UNIT of a reward (rewards are not negative),
+ * so an update is two relaxed fetch_adds. A thread buffers its playouts
+ * in Updates and adds them with flush, so with a flush every few playouts
+ * the threads write the shared lines once per flush instead of once per
+ * move. A reader may see the score of an update before its count, which
+ * moves an average by less than one playout, nothing the epsilon-greedy
+ * policy can tell apart. Until share is called flush adds with plain
+ * loads and stores, a locked add costs a single-threaded search about as
+ * much as the rest of its MAST updates.
+ */
+class MASTTable {
+public:
+	using reward_t = State::reward_t;
+
+	struct ActionStats {
+		reward_t score;
+		long long times;
+	};
+
+	/* updates of one thread not added to the table yet */
+	class Updates {
+	public:
+		explicit Updates(const MASTTable& table);
+
+		void add(AgentID id, int actionIdx, reward_t reward);
+
+	private:
+		friend class MASTTable;
+
+		int actionCount;
+		std::vector<reward_t> scores;
+		std::vector<int> times;
+		std::vector<int> touched;
+	};
+
+	MASTTable(int agentCount, int actionCount);
+
+	ActionStats get(AgentID id, int actionIdx) const;
+	void flush(Updates& updates);
+	/* from now on more than one thread updates the table */
+	void share();
+	/* multiplies every score by factor, no thread may update the table meanwhile */
+	void decay(reward_t factor);
+
+private:
+	static constexpr reward_t SCORE_UNIT = 1 << 16;
+
+	struct Entry {
+		std::atomic<std::int64_t> score;
+		std::atomic<std::int64_t> times;
+	};
+
+	static std::int64_t toFixed(reward_t reward);
+
+	int actionCount;
+	int entryCount;
+	std::unique_ptr<Entry[]> entries;
+	bool shared = false;
+};
+
+#endif /* MAST_TABLE_HPP */
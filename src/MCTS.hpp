@@ -0,0 +1,167 @@
+#ifndef MCTS_HPP
+#define MCTS_HPP
+
+#include "Common.hpp"
+#include "Agent.hpp"
+#include "State.hpp"
+#include "Move.hpp"
+#include "MCTSDetail.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+ * UCT search with random playouts over a concrete game type. States are
+ * held as game_t values and every call goes to game_t directly (it should
+ * be final with its hot path in the header), so the compiler can inline
+ * apply, isDecided and the legal move generation. Nodes live in one vector
+ * linked by indices, the children of a node are a contiguous range created
+ * in random order on its first expansion, so there is no RTTI, no
+ * shared_ptr and no allocation per node.
+ */
+template<class game_t>
+class MCTS {
+public:
+	using reward_t = State::reward_t;
+	using param_t = Agent::param_t;
+	using index_t = std::uint32_t;
+
+	MCTS(const game_t& rootState, param_t exploreFactor) :
+		rootState(rootState), exploreFactor(exploreFactor) {
+		resetTree();
+	}
+
+	/* runs iterations while the timer has time left, returns their number */
+	int search(const CalcTimer& timer) {
+		int iterations = 0;
+		while (timer.isTimeLeft()) {
+			game_t state = rootState;
+			const index_t leaf = treePolicy(state);
+			backup(leaf, mcts_detail::rollout(state));
+			++iterations;
+		}
+		return iterations;
+	}
+
+	move_t getBestMove() const {
+		const auto& root = nodes[ROOT];
+		assert(root.expandedCount > 0);
+		const auto first = nodes.begin() + root.firstChild;
+		const auto best = std::max_element(first, first + root.expandedCount,
+			[](const Node& n1, const Node& n2){ return n1.visits < n2.visits; });
+		return best->move;
+	}
+
+	/* makes the child reached by move the new root and keeps its subtree */
+	void advance(move_t move) {
+		const auto& root = nodes[ROOT];
+		index_t newRoot = NO_NODE;
+		for (index_t i = 0; i < root.expandedCount; ++i)
+			if (nodes[root.firstChild + i].move == move)
+				newRoot = root.firstChild + i;
+
+		rootState.apply(move);
+		if (newRoot == NO_NODE)
+			resetTree();
+		else
+			keepSubtree(newRoot);
+	}
+
+	const game_t& getRootState() const {
+		return rootState;
+	}
+
+	int getNodeCount() const {
+		return nodes.size();
+	}
+
+private:
+	static constexpr index_t ROOT = 0;
+	static constexpr index_t NO_NODE = ~index_t(0);
+
+	struct Node {
+		/* rewards of the agent who played move */
+		reward_t score = 0;
+		int visits = 0;
+		index_t parent = NO_NODE;
+		index_t firstChild = NO_NODE;
+		std::uint16_t childCount = 0;
+		std::uint16_t expandedCount = 0;
+		move_t move = 0;
+		std::int8_t mover = NONE;
+	};
+
+	index_t treePolicy(game_t& state) {
+		index_t node = ROOT;
+		while (!state.isTerminal()) {
+			if (nodes[node].firstChild == NO_NODE)
+				createChildren(node, state);
+			auto& current = nodes[node];
+			if (current.expandedCount < current.childCount) {
+				node = current.firstChild + current.expandedCount++;
+				state.apply(nodes[node].move);
+				return node;
+			}
+			node = select(current);
+			state.apply(nodes[node].move);
+		}
+		return node;
+	}
+
+	void createChildren(index_t node, const game_t& state) {
+		moves.clear();
+		for (const auto move : state.getValidMovesMask())
+			moves.push(move);
+		std::shuffle(moves.begin(), moves.end(), Random::rng);
+
+		const index_t firstChild = nodes.size();
+		nodes.resize(nodes.size() + moves.size());
+		for (int i = 0; i < moves.size(); ++i) {
+			auto& child = nodes[firstChild + i];
+			child.parent = node;
+			child.move = moves[i];
+			child.mover = state.getTurn();
+		}
+		nodes[node].firstChild = firstChild;
+		nodes[node].childCount = moves.size();
+	}
+
+	index_t select(const Node& node) const {
+		const param_t logVisits = std::log(node.visits);
+		return mcts_detail::argmax(node.firstChild, node.firstChild + node.childCount,
+			[this, logVisits](index_t i) {
+				return mcts_detail::uct(nodes[i].score / nodes[i].visits, nodes[i].visits, logVisits, exploreFactor);
+			});
+	}
+
+	void backup(index_t node, reward_t agent1Reward) {
+		for (; node != NO_NODE; node = nodes[node].parent) {
+			auto& current = nodes[node];
+			current.score += mcts_detail::eval(agent1Reward, current.mover);
+			++current.visits;
+		}
+	}
+
+	void resetTree() {
+		nodes.assign(1, Node());
+		nodes[ROOT].mover = mcts_detail::getRootMover(rootState);
+	}
+
+	/* copies the subtree of newRoot in breadth-first order to a new vector */
+	void keepSubtree(index_t newRoot) {
+		std::vector<Node> kept(nodes.size());
+		kept.resize(mcts_detail::keepSubtree(nodes, kept, newRoot, NO_NODE));
+		nodes.swap(kept);
+	}
+
+private:
+	std::vector<Node> nodes;
+	game_t rootState;
+	param_t exploreFactor;
+	MoveList moves;
+};
+
+#endif /* MCTS_HPP */
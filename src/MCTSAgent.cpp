@@ -1,76 +1,73 @@
 #include "MCTSAgent.hpp"
 
 #include <cassert>
+#include <algorithm>
 
 using param_t = MCTSAgent::param_t;
 using reward_t = MCTSAgent::reward_t;
-using MCTSNodeBase = MCTSAgent::MCTSNodeBase;
+using index_t = MCTSAgent::index_t;
 
 MCTSAgent::MCTSAgent(AgentID id, double calcLimitInMs,
 		const up<State>& initialState, const AgentArgs& args) :
-	MCTSAgentBase(id, calcLimitInMs, std::mku<MCTSNode>(initialState)),
+	MCTSAgentBase(id, calcLimitInMs, initialState, args),
 	exploreFactor(getOrDefault(args, "exploreFactor", 0.4)) {
-
+	usePlayoutPool(args);
 }
 
-MCTSAgent::MCTSNode::MCTSNode(const up<State>& initialState) : MCTSNodeBase(initialState) {
+up<MCTSAgentBase> MCTSAgent::createWorker(const up<State>& rootState, const AgentArgs& args) const {
+	return std::mku<MCTSAgent>(getID(), timer.getLimit(), rootState, args);
+}
 
+index_t MCTSAgent::select(index_t node) {
+	return selectUCT(node, exploreFactor);
 }
 
-param_t MCTSAgent::eval(const sp<MCTSNodeBase>& node, const sp<Action>&) {
-	const auto& v = std::dynamic_pointer_cast<MCTSNode>(node);
-	const auto& p = std::dynamic_pointer_cast<MCTSNode>(node->parent.lock());
-	assert(v);
-	assert(p);
-	param_t exploitationFactor = param_t(v->stats.score) / v->stats.visits;
-	param_t explorationFactor = std::sqrt(2.0 * std::log(p->stats.visits) / v->stats.visits);
+param_t MCTSAgent::eval(index_t node) {
+	const auto& v = nodes[node];
+	assert(v.parent != NO_NODE);
+	param_t exploitationFactor = param_t(nodeScores[node]) / nodeVisits[node];
+	param_t explorationFactor = std::sqrt(2.0 * std::log(nodeVisits[v.parent]) / nodeVisits[node]);
 	return exploitationFactor + exploreFactor * explorationFactor;
 }
 
-void MCTSAgent::defaultPolicy(const sp<MCTSNodeBase>& initialNode) {
-	auto state = initialNode->cloneState();
+void MCTSAgent::defaultPolicy(index_t initialNode) {
+	auto& state = beginRollout(initialNode);
 
-     while (!state->isTerminal()) {
-		auto actions = state->getValidActions();
-		const auto& action = Random::choice(actions);
-		state->apply(action);
+	if (batchPlayouts > 1 && !state.isDecided()) {
+		randomPlayouts(state);
+		return;
 	}
 
+	while (!state.isDecided())
+		play(state, Random::choice(state.getValidMovesMask()));
+
 	for (int i = 0; i < maxAgentCount; ++i)
-		agentRewards[i] = state->getReward(AgentID(i));
+		agentRewards[i] = state.getReward(AgentID(i));
 }
 
-void MCTSAgent::backup(sp<MCTSNodeBase> node) {
+void MCTSAgent::backup(index_t node) {
 	int timesTreeAscended = 0;
 	auto myReward = agentRewards[getID()];
 	auto myID = getID();
 
-	while (node) {
-		node->addReward(myReward, myID);
-		node = node->parent.lock();
+	while (node != NO_NODE) {
+		prefetchAncestor(timesTreeDescended - timesTreeAscended);
+		addReward(node, myReward, myID, playoutCount);
+		node = nodes[node].parent;
 		++timesTreeAscended;
 	}
 
 	assert(timesTreeDescended + 1 == timesTreeAscended);
 }
 
-sp<MCTSNodeBase> MCTSAgent::MCTSNode::makeChildFromState(up<State>&& state) {
-	return std::mksh<MCTSNode>(std::move(state));
-}
-
-MCTSAgent::MCTSNode::MCTSNode(up<State>&& initialState) : MCTSNodeBase(std::move(initialState)) {
-
-}
-
 std::vector<KeyValue> MCTSAgent::getDesc(double avgSimulationCount) const {
-	int averageSpeedSimPerSec = std::round((simulationCount * 1000.0) / timer.getTotalCalcTime());
-	return { { "MCTS Agent with UCT selection and random simulation policy.", "" },
-		{ "", "" },
-		{ "Turn time limit", std::to_string(timer.getLimit()) + " ms" },
-		{ "Average turn time", std::to_string(timer.getAverageCalcTime()) + " ms" },
-		{ "Average number of simulations per turn", std::to_string(avgSimulationCount) + " sim/turn" },
-		{ "Average simulation/s speed", std::to_string(averageSpeedSimPerSec) + " sim/sec" },
+	std::vector<KeyValue> desc { { "MCTS Agent with UCT selection and random simulation policy.", "" } };
+	appendBaseDesc(desc, avgSimulationCount);
+	desc.insert(desc.end(), {
 		{ "", "" },
 		{ "Exploration speed constant (C) in UCT policy", std::to_string(exploreFactor) },
-	};
+		{ "Random playouts per selected leaf", std::to_string(batchPlayouts) },
+		{ "Playout pool threads", std::to_string(getLeafThreadCount()) },
+	});
+	return desc;
 }
@@ -8,7 +8,7 @@ class MCTSAgent : public MCTSAgentBase {
 public:
 	using param_t = MCTSAgentBase::param_t;
 	using reward_t = MCTSAgentBase::reward_t;
-	using MCTSNodeBase = MCTSAgentBase::MCTSNode;
+	using index_t = MCTSAgentBase::index_t;
 
   	MCTSAgent(AgentID id, double calcLimitInMs,
 		const up<State> &initialState, const AgentArgs& args);
@@ -16,15 +16,11 @@ public:
 	std::vector<KeyValue> getDesc(double avgSimulationCount=0) const override;
 
 protected:
-	struct MCTSNode : public MCTSNodeBase {
-		MCTSNode(const up<State>& initialState);
-		MCTSNode(up<State>&& initialState);
-		sp<MCTSNodeBase> makeChildFromState(up<State>&& state) override;
-	};
-
-	param_t eval(const sp<MCTSNodeBase>& node, const sp<Action>& action) override;
-	void defaultPolicy(const sp<MCTSNodeBase>& initialNode) override;
-	void backup(sp<MCTSNodeBase> node) override;
+	up<MCTSAgentBase> createWorker(const up<State>& rootState, const AgentArgs& args) const override;
+	index_t select(index_t node) override;
+	param_t eval(index_t node) override;
+	void defaultPolicy(index_t initialNode) override;
+	void backup(index_t node) override;
 
 private:
 	param_t exploreFactor;
@@ -2,111 +2,524 @@
 
 #include <cassert>
 #include <algorithm>
+#include <limits>
+#include <cmath>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_AVX2_KERNEL 1
+#endif
 
 using param_t = MCTSAgentBase::param_t;
 using reward_t = MCTSAgentBase::reward_t;
+using index_t = MCTSAgentBase::index_t;
+
+thread_local std::vector<MCTSAgentBase::NodeStorage<MCTSAgentBase::MCTSNode>> MCTSAgentBase::spareArenas;
+
+namespace {
+	/*
+	 * UCT kernels of selectUCT over a child range, the value of child i is
+	 * scores[i] / visits[i] + exploreFactor * sqrt(logTerm / visits[i]),
+	 * blended to (1 - w) * value + w * a with the optional per child w, a.
+	 * Both compute it in the same order as the eval of MCTSAgent, so they
+	 * pick the same child, the first one on ties.
+	 */
+	int argmaxUCTScalar(const reward_t* scores, const int* visits, int first, int count,
+			param_t logTerm, param_t exploreFactor, const param_t* blendWeights,
+			const param_t* blendValues, param_t& bestValue) {
+		int best = -1;
+		for (int i = first; i < count; ++i) {
+			param_t value = param_t(scores[i]) / visits[i] + exploreFactor * std::sqrt(logTerm / visits[i]);
+			if (blendWeights)
+				value = (1 - blendWeights[i]) * value + blendWeights[i] * blendValues[i];
+			if (best == -1 || value > bestValue)
+				bestValue = value, best = i;
+		}
+		return best;
+	}
+
+#if HAS_AVX2_KERNEL
+	const bool hasAVX2 = __builtin_cpu_supports("avx2");
+
+	__attribute__((target("avx2")))
+	int argmaxUCTAVX2(const reward_t* scores, const int* visits, int count,
+			param_t logTerm, param_t exploreFactor, const param_t* blendWeights,
+			const param_t* blendValues) {
+		const __m256d logTerms = _mm256_set1_pd(logTerm);
+		const __m256d exploreFactors = _mm256_set1_pd(exploreFactor);
+		const __m256d ones = _mm256_set1_pd(1);
+		const __m256d step = _mm256_set1_pd(4);
+		__m256d indices = _mm256_set_pd(3, 2, 1, 0);
+		__m256d bestValues = _mm256_set1_pd(-std::numeric_limits<param_t>::infinity());
+		__m256d bestIndices = _mm256_setzero_pd();
+
+		int i = 0;
+		for (; i + 4 <= count; i += 4) {
+			const __m256d n = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(visits + i)));
+			const __m256d exploitation = _mm256_div_pd(_mm256_loadu_pd(scores + i), n);
+			const __m256d exploration = _mm256_sqrt_pd(_mm256_div_pd(logTerms, n));
+			__m256d values = _mm256_add_pd(exploitation, _mm256_mul_pd(exploreFactors, exploration));
+			if (blendWeights) {
+				const __m256d w = _mm256_loadu_pd(blendWeights + i);
+				values = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(ones, w), values),
+					_mm256_mul_pd(w, _mm256_loadu_pd(blendValues + i)));
+			}
+			const __m256d greater = _mm256_cmp_pd(values, bestValues, _CMP_GT_OQ);
+			bestValues = _mm256_blendv_pd(bestValues, values, greater);
+			bestIndices = _mm256_blendv_pd(bestIndices, indices, greater);
+			indices = _mm256_add_pd(indices, step);
+		}
+
+		int best = -1;
+		param_t bestValue = 0;
+		if (i > 0) {
+			alignas(32) param_t laneValues[4], laneIndices[4];
+			_mm256_store_pd(laneValues, bestValues);
+			_mm256_store_pd(laneIndices, bestIndices);
+			for (int lane = 0; lane < 4; ++lane)
+				if (best == -1 || laneValues[lane] > bestValue ||
+						(laneValues[lane] == bestValue && laneIndices[lane] < best))
+					bestValue = laneValues[lane], best = int(laneIndices[lane]);
+		}
+
+		param_t tailValue;
+		const int tailBest = argmaxUCTScalar(scores, visits, i, count, logTerm, exploreFactor,
+			blendWeights, blendValues, tailValue);
+		if (tailBest != -1 && (best == -1 || tailValue > bestValue))
+			best = tailBest;
+		return best;
+	}
+#endif
+
+	std::string perIteration(bool counted, bool available, long long count, long long iterations) {
+		if (!counted)
+			return "off";
+		if (!available)
+			return "unavailable";
+		return std::to_string(iterations ? double(count) / iterations : 0);
+	}
+}
 
-MCTSAgentBase::MCTSAgentBase(AgentID id, double calcLimitInMs, up<MCTSAgentBase::MCTSNode>&& root) :
+MCTSAgentBase::MCTSAgentBase(AgentID id, double calcLimitInMs, const up<State>& initialState,
+		const AgentArgs& args) :
 	Agent(id, calcLimitInMs),
-	root(std::move(root)),
-	maxAgentCount(this->root->state->getAgentCount()),
-	agentRewards(maxAgentCount) {
+	pageMode(Pages::parseMode(getOrDefault(args, "hugePages", 0))),
+	numaLocal(getOrDefault(args, "numaLocal", 0)),
+	nodes(PageAllocator<MCTSNode>(pageMode, numaLocal)),
+	nodeScores(nodes.get_allocator()),
+	nodeVisits(nodes.get_allocator()),
+	maxAgentCount(initialState->getAgentCount()),
+	agentRewards(maxAgentCount),
+	batchPlayouts(getOrDefault(args, "batchPlayouts", 1)),
+	undoSearch(getOrDefault(args, "undoSearch", 0)),
+	statelessNodes(getOrDefault(args, "statelessNodes", 0)),
+	simdSelect(getOrDefault(args, "simdSelect", 1)),
+	KFactor(getOrDefault(args, "KFactor", 50.0)),
+	raveMinVisits(getOrDefault(args, "raveMinVisits", 16)),
+	reclaimBudget(getOrDefault(args, "reclaimBudget", 32)),
+	reRootTimer(0),
+	nodeBudget(getOrDefault(args, "nodeBudget", 0)),
+	compactTreeAfterMove(getOrDefault(args, "compactTree", 0)),
+	compactArena(nodes.get_allocator()),
+	compactionTimer(0),
+	prefetchDistance(getOrDefault(args, "prefetchDistance", 0)),
+	countCacheMisses(getOrDefault(args, "countCacheMisses", 0)),
+	threadCount(getOrDefault(args, "threads", 1)),
+	workerArgs(args) {
+
+	freeRanges.resize(MAX_MOVE_COUNT + 1);
+	if (!spareArenas.empty()) {
+		if (spareArenas.back().get_allocator() == nodes.get_allocator())
+			nodes.swap(spareArenas.back());
+		spareArenas.pop_back();
+	}
+	if (nodeBudget)
+		nodes.reserve(nodeBudget);
+	root = allocateNodes(1);
+	nodes[root].state = initialState->clone();
+	nodes[root].setFromState(*initialState);
+	if (statelessNodes)
+		undoSearch = true;
+	playedMoves.reserve(initialState->getActionCount());
+	workerArgs["threads"] = 1;
+	workerArgs["leafThreads"] = 0;
+}
 
+/* for agents whose defaultPolicy plays batchPlayouts through randomPlayouts */
+void MCTSAgentBase::usePlayoutPool(const AgentArgs& args) {
+	if (const int leafThreads = getOrDefault(args, "leafThreads", 0); leafThreads > 0) {
+		if (threadCount > 1)
+			errorExit("root-parallel workers have no playout pool, threads and leafThreads do not combine");
+		playoutPool = std::mku<PlayoutPool>(leafThreads);
+	}
 }
 
-MCTSAgentBase::MCTSNode::MCTSNode(const up<State>& initialState)
-	: state(initialState->clone()), actions(state->getValidActions()) {
-	std::shuffle(actions.begin(), actions.end(), Random::rng);
+/* for agents whose defaultPolicy plays one playout at a time */
+void MCTSAgentBase::rejectLeafPlayouts(const AgentArgs& args, const std::string& agentName) const {
+	if (getOrDefault(args, "batchPlayouts", 1) != 1 || getOrDefault(args, "leafThreads", 0) > 0)
+		errorExit(agentName + " plays one playout at a time, batchPlayouts and leafThreads do not apply");
 }
 
-MCTSAgentBase::MCTSNode::MCTSNode(up<State>&& initialState)
-	: state(std::move(initialState)), actions(state->getValidActions()) {
-	std::shuffle(actions.begin(), actions.end(), Random::rng);
+MCTSAgentBase::~MCTSAgentBase() {
+	nodes.clear();
+	spareArenas.push_back(std::move(nodes));
 }
 
 sp<Action> MCTSAgentBase::getAction(const up<State>&) {
 	timer.startCalculation();
+	if (threadCount > 1 && workers.empty())
+		for (int i = 1; i < threadCount; ++i)
+			workers.push_back(createWorker(nodes[root].state, workerArgs));
+
+	std::vector<std::thread> threads;
+	if (!workers.empty()) {
+		const auto seed = Random::rng();
+		for (int i = 0; i < int(workers.size()); ++i)
+			threads.emplace_back([this, i, seed]() {
+				Random::seed(seed, i + 1);
+				workers[i]->search(timer);
+				workers[i]->postWork();
+			});
+	}
+	search(timer);
+	for (auto& thread : threads)
+		thread.join();
+
+	const auto result = getBestAction();
+	postWork();
+	timer.stopCalculation();
+
+	return result;
+}
+
+/* iterations on the calling thread until turnTimer runs out */
+void MCTSAgentBase::search(const CalcTimer& turnTimer) {
 	currentSimulationCount = 0;
+	if (undoSearch)
+		searchState = nodes[root].cloneState();
+	/* a counter counts the thread that opened it, so they are opened here */
+	up<PerfCounter> cacheMisses, l1Misses;
+	if (countCacheMisses) {
+		cacheMisses = std::mku<PerfCounter>(PerfCounter::Event::CACHE_MISSES);
+		l1Misses = std::mku<PerfCounter>(PerfCounter::Event::L1D_READ_MISSES);
+		cacheMisses->start(), l1Misses->start();
+	}
 
-	while (timer.isTimeLeft()) {
+	while (turnTimer.isTimeLeft()) {
+		if (isOverNodeBudget() && liveNodeCount != stuckLiveNodeCount)
+			evictColdSubtrees();
 		auto selectedNode = treePolicy();
 		defaultPolicy(selectedNode);
 		backup(selectedNode);
-		++simulationCount;
-		++currentSimulationCount;
+		endRollout();
+		reclaimNodes(reclaimBudget);
+		simulationCount += playoutCount;
+		currentSimulationCount += playoutCount;
+		playoutCount = 1;
+		++countedIterations;
 	}
 
-	const auto result = root->getBestAction();
-	postWork();
-	timer.stopCalculation();
-
-	return result;
+	if (countCacheMisses) {
+		cacheMisses->stop(), l1Misses->stop();
+		hasCacheMissCounts = cacheMisses->isAvailable();
+		hasL1MissCounts = l1Misses->isAvailable();
+		cacheMissCount += cacheMisses->getCount();
+		l1MissCount += l1Misses->getCount();
+	}
 }
 
-sp<MCTSAgentBase::MCTSNode> MCTSAgentBase::treePolicy() {
+index_t MCTSAgentBase::treePolicy() {
 	auto currentNode = root;
 	timesTreeDescended = 0;
+	if (prefetchDistance) {
+		descentPath.clear();
+		descentPath.push_back(root);
+	}
 
-	while (!currentNode->isTerminal()) {
+	while (!nodes[currentNode].isTerminal()) {
+		if (nodes[currentNode].firstChild == NO_NODE && currentNode != root && isOverNodeBudget())
+			break;
 		++timesTreeDescended;
-		if (currentNode->shouldExpand())
-			return expand(currentNode);
+		if (nodes[currentNode].shouldExpand()) {
+			currentNode = expand(currentNode);
+			if (prefetchDistance)
+				descentPath.push_back(currentNode);
+			if (undoSearch)
+				play(*searchState, nodes[currentNode].move);
+			if (statelessNodes)
+				nodes[currentNode].setFromState(*searchState);
+			return currentNode;
+		}
 		currentNode = select(currentNode);
+		if (prefetchDistance) {
+			descentPath.push_back(currentNode);
+			prefetchChildren(currentNode);
+		}
+		if (undoSearch)
+			play(*searchState, nodes[currentNode].move);
 	}
 
 	return currentNode;
 }
 
+State& MCTSAgentBase::beginRollout(index_t node) {
+	if (undoSearch)
+		return *searchState;
+	rolloutState = nodes[node].cloneState();
+	return *rolloutState;
+}
+
+void MCTSAgentBase::play(State& state, move_t move) {
+	if (undoSearch)
+		playedMoves.push_back({ move, state.getUndoInfo() });
+	state.apply(move);
+}
+
+void MCTSAgentBase::endRollout() {
+	while (!playedMoves.empty()) {
+		searchState->undo(playedMoves.back().move, playedMoves.back().undoInfo);
+		playedMoves.pop_back();
+	}
+}
+
 bool MCTSAgentBase::MCTSNode::isTerminal() const {
-	return state->isTerminal();
+	return terminal;
 }
 
 bool MCTSAgentBase::MCTSNode::shouldExpand() const {
-	return nextActionToResolveIdx < int(actions.size());
+	return firstChild == NO_NODE || expandedCount < childCount;
 }
 
-int MCTSAgentBase::MCTSNode::expandGetIdx() {
-	assert(shouldExpand());
-	assert(nextActionToResolveIdx == int(children.size()));
-	assert(nextActionToResolveIdx < int(actions.size()));
+void MCTSAgentBase::MCTSNode::setFromState(const State& state) {
+	turn = state.getTurn();
+	terminal = state.isTerminal();
+}
+
+index_t MCTSAgentBase::allocateNodes(int count) {
+	liveNodeCount += count;
+	peakNodeCount = std::max(peakNodeCount, liveNodeCount);
+	auto& ranges = freeRanges[count];
+	/* within a budget a longer free range is split rather than growing the arena */
+	for (int length = count + 1; nodeBudget && ranges.empty() && length <= MAX_MOVE_COUNT; ++length)
+		if (!freeRanges[length].empty()) {
+			ranges.push_back(freeRanges[length].back());
+			freeRanges[length].pop_back();
+			freeRanges[length - count].push_back(ranges.back() + count);
+		}
+	if (ranges.empty()) {
+		const index_t first = nodes.size();
+		nodes.resize(nodes.size() + count);
+		nodeScores.resize(nodes.size());
+		nodeVisits.resize(nodes.size());
+		return first;
+	}
+
+	const index_t first = ranges.back();
+	ranges.pop_back();
+	for (index_t i = first; i < first + count; ++i)
+		nodes[i] = MCTSNode();
+	std::fill_n(nodeScores.begin() + first, count, 0);
+	std::fill_n(nodeVisits.begin() + first, count, 0);
+	return first;
+}
+
+void MCTSAgentBase::releaseNodes(index_t first, int count) {
+	liveNodeCount -= count;
+	if (count > 0)
+		freeRanges[count].push_back(first);
+	if (actionsAMAF)
+		actionsAMAF->release(first, count);
+}
+
+/* frees the states and child ranges of the subtree of node (and whatever else is queued), the record of node stays allocated */
+void MCTSAgentBase::releaseSubtree(index_t node) {
+	nodes[node].state.reset();
+	discardChildren(node);
+	reclaimNodes(std::numeric_limits<int>::max());
+}
+
+/* detaches the child range of node and queues it for reclaimNodes */
+void MCTSAgentBase::discardChildren(index_t node) {
+	auto& current = nodes[node];
+	releaseUntriedSlot(current);
+	if (current.firstChild == NO_NODE)
+		return;
+	reclaimQueue.push_back({ current.firstChild, current.childCount, current.expandedCount });
+	current.firstChild = NO_NODE;
+	current.childCount = current.expandedCount = 0;
+}
+
+/* a range is released once all its expanded records were freed, so queued records are never reallocated */
+void MCTSAgentBase::reclaimNodes(int budget) {
+	while (budget > 0 && !reclaimQueue.empty()) {
+		auto range = reclaimQueue.back();
+		reclaimQueue.pop_back();
+		if (range.expandedCount == 0) {
+			releaseNodes(range.first, range.count);
+			continue;
+		}
+
+		const index_t node = range.first + --range.expandedCount;
+		reclaimQueue.push_back(range);
+		nodes[node].state.reset();
+		discardChildren(node);
+		--budget;
+	}
+}
+
+/* leaves room for the largest child range, so a budget is never exceeded */
+bool MCTSAgentBase::isOverNodeBudget() const {
+	return nodeBudget && liveNodeCount + MAX_MOVE_COUNT > nodeBudget;
+}
 
-	const auto& action = actions[nextActionToResolveIdx];
-	children.push_back(makeChildFromState(state->applyCopy(action)));
-	return nextActionToResolveIdx++;
+/*
+ * Collapses subtrees top-down by a doubling visit threshold, the root and
+ * its children are kept. A pass that does not get below its target leaves
+ * the tree as small as the threshold can make it, so it is not repeated
+ * until liveNodeCount changes, meanwhile leaves are not expanded.
+ */
+void MCTSAgentBase::evictColdSubtrees() {
+	const int liveBefore = liveNodeCount;
+	reclaimNodes(std::numeric_limits<int>::max());
+	const int target = nodeBudget - nodeBudget / 4;
+	for (int threshold = 2; liveNodeCount > target; threshold *= 2) {
+		evictStack.push_back(root);
+		while (!evictStack.empty()) {
+			const auto& current = nodes[evictStack.back()];
+			evictStack.pop_back();
+			for (index_t i = current.firstChild; i < current.firstChild + current.expandedCount; ++i) {
+				if (nodes[i].firstChild == NO_NODE)
+					continue;
+				if (nodeVisits[i] < threshold)
+					discardChildren(i), ++evictedSubtreeCount;
+				else
+					evictStack.push_back(i);
+			}
+		}
+		reclaimNodes(std::numeric_limits<int>::max());
+		if (threshold > nodeVisits[root])
+			break;
+	}
+	stuckLiveNodeCount = liveNodeCount > target ? liveNodeCount : -1;
+	if (liveNodeCount < liveBefore)
+		coalesceFreeRanges();
 }
 
-sp<MCTSAgentBase::MCTSNode> MCTSAgentBase::expand(const sp<MCTSNode>& node) {
-	int expandIdx = expandGetIdx(node);
-	assert(expandIdx == int(node->children.size()) - 1);
-	return node->children[expandIdx];
+/* rebuilds freeRanges from maximal runs of adjacent free records, so evicted ranges can be split for any length */
+void MCTSAgentBase::coalesceFreeRanges() {
+	std::vector<bool> isFree(nodes.size());
+	for (int length = 1; length <= MAX_MOVE_COUNT; ++length) {
+		for (const auto first : freeRanges[length])
+			std::fill(isFree.begin() + first, isFree.begin() + first + length, true);
+		freeRanges[length].clear();
+	}
+
+	for (index_t first = 0; first < nodes.size(); ++first) {
+		if (!isFree[first])
+			continue;
+		index_t end = first;
+		while (end < nodes.size() && isFree[end] && end - first < MAX_MOVE_COUNT)
+			++end;
+		freeRanges[end - first].push_back(first);
+		first = end - 1;
+	}
 }
 
-int MCTSAgentBase::expandGetIdx(const sp<MCTSNode>& node) {
-	int expandIdx = node->expandGetIdx();
-	assert(expandIdx == int(node->children.size()) - 1);
-	node->children[expandIdx]->parent = node;
-	return expandIdx;
+void MCTSAgentBase::createChildren(index_t node, const State& state) {
+	assert(nodes[node].firstChild == NO_NODE);
+	const auto validMoves = state.getValidMovesMask();
+	const int childCount = validMoves.count();
+	const index_t firstChild = allocateNodes(childCount);
+	for (index_t i = firstChild; i < firstChild + childCount; ++i)
+		nodes[i].parent = node;
+
+	index_t slot = untriedMoves.size();
+	if (freeUntriedSlots.empty())
+		untriedMoves.push_back(validMoves);
+	else {
+		slot = freeUntriedSlots.back();
+		freeUntriedSlots.pop_back();
+		untriedMoves[slot] = validMoves;
+	}
+
+	auto& current = nodes[node];
+	current.firstChild = firstChild;
+	current.childCount = childCount;
+	current.untriedSlot = slot;
 }
 
-sp<MCTSAgentBase::MCTSNode> MCTSAgentBase::select(const sp<MCTSNode>& node) {
-	int selectIdx = selectGetIdx(node);
-	assert(selectIdx < int(node->children.size()));
-	assert(selectIdx < int(node->actions.size()));
-	return node->children[selectIdx];
+void MCTSAgentBase::useAMAF() {
+	const int maxActionCount = nodes[root].state->getActionCount();
+	actionsAMAF = std::mku<AMAFTable>(maxActionCount);
+	blendWeights.resize(maxActionCount);
+	blendValues.resize(maxActionCount);
 }
 
-int MCTSAgentBase::selectGetIdx(const sp<MCTSNode>& node) {
-	const auto& children = node->children;
-	const auto& actions = node->actions;
-	assert(!children.empty());
-	assert(children.size() <= actions.size());
+AMAFTable::NodeStats MCTSAgentBase::getNodeActionsStats(index_t node) {
+	auto actionsStats = actionsAMAF->find(node);
+	if (!actionsStats && nodes[node].firstChild != NO_NODE && nodeVisits[node] >= raveMinVisits)
+		actionsStats = actionsAMAF->allocate(node, getChildMoves(node));
+	return actionsStats;
+}
 
-	int selectIdx = 0;
-	auto evaluation = eval(children[0], actions[0]);
-	const int childCount = children.size();
+void MCTSAgentBase::releaseUntriedSlot(MCTSNode& node) {
+	if (node.untriedSlot == NO_NODE)
+		return;
+	freeUntriedSlots.push_back(node.untriedSlot);
+	node.untriedSlot = NO_NODE;
+}
+
+/* moves of all children of a node with children, the expanded ones and the untried ones */
+MoveMask MCTSAgentBase::getChildMoves(index_t node) const {
+	const auto& current = nodes[node];
+	assert(current.firstChild != NO_NODE);
+	MoveMask moves;
+	if (current.untriedSlot != NO_NODE)
+		moves = untriedMoves[current.untriedSlot];
+	for (index_t i = current.firstChild; i < current.firstChild + current.expandedCount; ++i)
+		moves.set(nodes[i].move);
+	return moves;
+}
 
-	for (int i = 1; i < childCount; ++i) {
-		auto curEvaluation = eval(children[i], actions[0]);
+index_t MCTSAgentBase::expand(index_t node) {
+	return expandGetIdx(node);
+}
+
+index_t MCTSAgentBase::expandGetIdx(index_t node) {
+	assert(nodes[node].shouldExpand());
+	if (nodes[node].firstChild == NO_NODE)
+		createChildren(node, statelessNodes ? *searchState : *nodes[node].state);
+
+	auto& parent = nodes[node];
+	auto& untried = untriedMoves[parent.untriedSlot];
+	const int untriedCount = parent.childCount - parent.expandedCount;
+	const index_t child = parent.firstChild + parent.expandedCount++;
+	nodes[child].move = untried.select(Random::rand(untriedCount));
+	untried.reset(nodes[child].move);
+	if (parent.expandedCount == parent.childCount)
+		releaseUntriedSlot(parent);
+
+	if (!statelessNodes) {
+		nodes[child].state = parent.state->applyCopy(nodes[child].move);
+		nodes[child].setFromState(*nodes[child].state);
+	}
+	return child;
+}
+
+index_t MCTSAgentBase::select(index_t node) {
+	return selectGetIdx(node);
+}
+
+index_t MCTSAgentBase::selectGetIdx(index_t node) {
+	const auto& parent = nodes[node];
+	assert(parent.expandedCount > 0);
+
+	index_t selectIdx = parent.firstChild;
+	auto evaluation = eval(selectIdx);
+	const index_t childrenEnd = parent.firstChild + parent.expandedCount;
+
+	for (index_t i = parent.firstChild + 1; i < childrenEnd; ++i) {
+		auto curEvaluation = eval(i);
 		if (curEvaluation > evaluation)
 			evaluation = curEvaluation, selectIdx = i;
 	}
@@ -114,43 +527,319 @@ int MCTSAgentBase::selectGetIdx(const sp<MCTSNode>& node) {
 	return selectIdx;
 }
 
-up<State> MCTSAgentBase::MCTSNode::cloneState() {
+/* same choice as selectGetIdx with the UCT eval, but log of the parent visits is taken once for all children */
+index_t MCTSAgentBase::selectUCT(index_t node, param_t exploreFactor,
+		const param_t* blendWeights, const param_t* blendValues) const {
+	const auto& parent = nodes[node];
+	assert(parent.expandedCount > 0);
+	const reward_t* scores = nodeScores.data() + parent.firstChild;
+	const int* visits = nodeVisits.data() + parent.firstChild;
+	const param_t logTerm = 2.0 * std::log(nodeVisits[node]);
+
+#if HAS_AVX2_KERNEL
+	if (simdSelect && hasAVX2)
+		return parent.firstChild + argmaxUCTAVX2(scores, visits, parent.expandedCount,
+			logTerm, exploreFactor, blendWeights, blendValues);
+#endif
+	param_t bestValue;
+	return parent.firstChild + argmaxUCTScalar(scores, visits, 0, parent.expandedCount,
+		logTerm, exploreFactor, blendWeights, blendValues, bestValue);
+}
+
+/* selectUCT with the beta and qAMAF of evalRAVE for every child, a weight of 0 leaves UCT alone */
+index_t MCTSAgentBase::selectRAVE(index_t node, param_t exploreFactor) {
+	const auto actionsStats = actionsAMAF->find(node);
+	if (!actionsStats)
+		return selectUCT(node, exploreFactor);
+
+	const auto& parent = nodes[node];
+	const param_t beta = std::sqrt(KFactor / (3 * nodeVisits[node] + KFactor));
+	for (int i = 0; i < parent.expandedCount; ++i) {
+		const auto actionStats = actionsStats.get(nodes[parent.firstChild + i].move);
+		const bool hasAMAF = actionStats && actionStats->visits > 0;
+		blendWeights[i] = hasAMAF ? beta : 0;
+		blendValues[i] = hasAMAF ? param_t(actionStats->reward) / actionStats->visits : 0;
+	}
+	return selectUCT(node, exploreFactor, blendWeights.data(), blendValues.data());
+}
+
+param_t MCTSAgentBase::evalRAVE(index_t node, param_t exploreFactor) {
+	const auto& v = nodes[node];
+	assert(v.parent != NO_NODE);
+
+	param_t exploitationFactor = param_t(nodeScores[node]) / nodeVisits[node];
+	param_t explorationFactor = std::sqrt(2.0 * std::log(nodeVisits[v.parent]) / nodeVisits[node]);
+	param_t qValue = exploitationFactor + exploreFactor * explorationFactor;
+
+	const auto parentStats = actionsAMAF->find(v.parent);
+	const auto actionStats = parentStats ? parentStats.get(v.move) : nullptr;
+	if (!actionStats || actionStats->visits == 0)
+		return qValue;
+
+	param_t qAMAF = param_t(actionStats->reward) / actionStats->visits;
+	param_t beta = std::sqrt(KFactor / (3 * nodeVisits[v.parent] + KFactor));
+
+	return (1 - beta) * qValue + beta * qAMAF;
+}
+
+/*
+ * Heads of what the next select from the node reads, fetched while the
+ * move to the node is played. The rest of each range is read in order,
+ * the hardware prefetcher follows it once the first line is there.
+ */
+void MCTSAgentBase::prefetchChildren(index_t node) const {
+	const auto& v = nodes[node];
+	if (v.expandedCount == 0)
+		return;
+	__builtin_prefetch(&nodeScores[v.firstChild], 0, 3);
+	__builtin_prefetch(&nodeVisits[v.firstChild], 0, 3);
+	__builtin_prefetch(&nodes[v.firstChild], 0, 3);
+}
+
+/* called by backup with the depth of the node it updates, the depth of the leaf is timesTreeDescended */
+void MCTSAgentBase::prefetchAncestor(int depth) const {
+	if (!prefetchDistance || depth < prefetchDistance)
+		return;
+	const index_t node = descentPath[depth - prefetchDistance];
+	__builtin_prefetch(&nodes[node], 0, 3);
+	__builtin_prefetch(&nodeScores[node], 1, 3);
+	__builtin_prefetch(&nodeVisits[node], 1, 3);
+}
+
+up<State> MCTSAgentBase::MCTSNode::cloneState() const {
 	return state->clone();
 }
 
-void MCTSAgentBase::MCTSNode::addReward(reward_t agentPlayingReward, AgentID whoIsPlaying) {
-	stats.score += whoIsPlaying != state->getTurn() ? agentPlayingReward : 1 - agentPlayingReward;
-	++stats.visits;
+void MCTSAgentBase::addReward(index_t node, reward_t agentPlayingReward, AgentID whoIsPlaying, int playouts) {
+	nodeScores[node] += whoIsPlaying != nodes[node].turn ? agentPlayingReward : playouts - agentPlayingReward;
+	nodeVisits[node] += playouts;
 }
 
-sp<Action> MCTSAgentBase::MCTSNode::getBestAction() {
-	int bestChildIdx = std::max_element(children.begin(), children.end(),
-		[](const auto& ch1, const auto& ch2){ return *ch1 < *ch2; }) - children.begin();
-	assert(bestChildIdx < int(actions.size()));
-	return actions[bestChildIdx];
+/* batchPlayouts random playouts of state into agentRewards, on the playout pool if there is one */
+void MCTSAgentBase::randomPlayouts(State& state) {
+	std::fill(agentRewards.begin(), agentRewards.end(), 0);
+	if (playoutPool)
+		playoutPool->run(state, batchPlayouts, agentRewards.data());
+	else
+		state.randomPlayouts(batchPlayouts, agentRewards.data());
+	playoutCount = batchPlayouts;
 }
 
-bool MCTSAgentBase::MCTSNode::operator<(const MCTSNode& o) const {
-	return stats.visits < o.stats.visits;
+sp<Action> MCTSAgentBase::getBestAction() const {
+	const auto& rootNode = nodes[root];
+	if (workers.empty()) {
+		assert(rootNode.expandedCount > 0);
+		const auto first = nodeVisits.begin() + rootNode.firstChild;
+		const auto best = std::max_element(first, first + rootNode.expandedCount) - nodeVisits.begin();
+		return rootNode.state->makeAction(nodes[best].move);
+	}
+
+	/* visits and then scores of the root children summed by move over all trees */
+	std::vector<std::pair<long long, reward_t>> moveStats(MAX_MOVE_COUNT);
+	auto addRootChildren = [&moveStats](const MCTSAgentBase& agent) {
+		const auto& agentRoot = agent.nodes[agent.root];
+		for (index_t i = agentRoot.firstChild; i < agentRoot.firstChild + agentRoot.expandedCount; ++i) {
+			moveStats[agent.nodes[i].move].first += agent.nodeVisits[i];
+			moveStats[agent.nodes[i].move].second += agent.nodeScores[i];
+		}
+	};
+	addRootChildren(*this);
+	for (const auto& worker : workers)
+		addRootChildren(*worker);
+	const move_t best = std::max_element(moveStats.begin(), moveStats.end()) - moveStats.begin();
+	assert(moveStats[best].first > 0);
+	return rootNode.state->makeAction(best);
 }
 
 void MCTSAgentBase::recordAction(const sp<Action>& action) {
-	auto recordActionIdx = std::find_if(root->actions.begin(), root->actions.end(),
-		[&action](const auto& x){ return action->equals(x); }) - root->actions.begin();
-	assert(recordActionIdx < int(root->actions.size()));
+	reRootTimer.startCalculation();
+	const move_t move = action->getIdx();
+	const index_t oldRoot = root;
+	const bool ownMove = nodes[oldRoot].turn == getID();
+	const index_t firstChild = nodes[oldRoot].firstChild;
+	const index_t childrenEnd = firstChild == NO_NODE ? NO_NODE :
+		firstChild + nodes[oldRoot].expandedCount;
+
+	index_t newRoot = NO_NODE;
+	for (index_t i = firstChild; i < childrenEnd; ++i)
+		if (nodes[i].move == move)
+			newRoot = i;
+
+	const bool expanded = newRoot != NO_NODE;
+	if (!expanded) {
+		newRoot = allocateNodes(1);
+		nodes[newRoot].move = move;
+	}
+	if (!nodes[newRoot].state) {
+		nodes[newRoot].state = nodes[oldRoot].state->applyCopy(action);
+		nodes[newRoot].setFromState(*nodes[newRoot].state);
+	}
 
-	if (recordActionIdx < int(root->children.size()))
-		root = root->children[recordActionIdx];
-	else
-		root = root->makeChildFromState(root->state->applyCopy(action));
-	assert(!root->parent.lock());
+	if (!expanded)
+		discardChildren(oldRoot);
+	else {
+		/* the new root stays in place, the rest of its range is queued around it */
+		const int before = newRoot - firstChild;
+		const int after = firstChild + nodes[oldRoot].childCount - newRoot - 1;
+		reclaimQueue.push_back({ firstChild, before, before });
+		reclaimQueue.push_back({ newRoot + 1, after, int(childrenEnd - newRoot - 1) });
+		releaseUntriedSlot(nodes[oldRoot]);
+		nodes[oldRoot].firstChild = NO_NODE;
+	}
+
+	nodes[oldRoot].state.reset();
+	releaseNodes(oldRoot, 1);
+	root = newRoot;
+	nodes[root].parent = NO_NODE;
+	if (reclaimBudget == 0)
+		reclaimNodes(std::numeric_limits<int>::max());
+	reRootTimer.stopCalculation();
+
+	if (compactTreeAfterMove && ownMove)
+		compactTree();
+	for (auto& worker : workers)
+		worker->recordAction(action);
+}
+
+/* queued and free records are dropped with the old arena, so the reclaim queue and free lists start empty */
+void MCTSAgentBase::compactTree() {
+	compactionTimer.startCalculation();
+	newIndices.assign(nodes.size(), NO_NODE);
+	compactArena.clear();
+	compactArena.reserve(liveNodeCount);
+
+	newIndices[root] = 0;
+	compactArena.push_back(std::move(nodes[root]));
+	for (index_t current = 0; current < compactArena.size(); ++current) {
+		const index_t firstChild = compactArena[current].firstChild;
+		if (firstChild == NO_NODE)
+			continue;
+		const index_t newFirstChild = compactArena.size();
+		for (index_t i = firstChild; i < firstChild + compactArena[current].childCount; ++i) {
+			newIndices[i] = compactArena.size();
+			compactArena.push_back(std::move(nodes[i]));
+			compactArena.back().parent = current;
+		}
+		compactArena[current].firstChild = newFirstChild;
+	}
+
+	std::vector<MoveMask> compactUntriedMoves;
+	for (auto& node : compactArena)
+		if (node.untriedSlot != NO_NODE) {
+			compactUntriedMoves.push_back(untriedMoves[node.untriedSlot]);
+			node.untriedSlot = compactUntriedMoves.size() - 1;
+		}
+	untriedMoves.swap(compactUntriedMoves);
+	freeUntriedSlots.clear();
+
+	nodes.swap(compactArena);
+	compactArena.clear();
+	NodeStorage<reward_t> compactScores(nodes.size(), 0, nodeScores.get_allocator());
+	NodeStorage<int> compactVisits(nodes.size(), 0, nodeVisits.get_allocator());
+	for (index_t i = 0; i < newIndices.size(); ++i)
+		if (newIndices[i] != NO_NODE) {
+			compactScores[newIndices[i]] = nodeScores[i];
+			compactVisits[newIndices[i]] = nodeVisits[i];
+		}
+	nodeScores.swap(compactScores);
+	nodeVisits.swap(compactVisits);
+	reclaimQueue.clear();
+	for (auto& ranges : freeRanges)
+		ranges.clear();
+	root = 0;
+	liveNodeCount = nodes.size();
+	if (actionsAMAF)
+		actionsAMAF->remap(newIndices, nodes.size());
+	compactionTimer.stopCalculation();
 }
 
 void MCTSAgentBase::postWork() {
 
 }
 
+void MCTSAgentBase::appendBaseDesc(std::vector<KeyValue>& desc, double avgSimulationCount) const {
+	int averageSpeedSimPerSec = std::round((getTotalSimulationCount() * 1000.0) / timer.getTotalCalcTime());
+	desc.insert(desc.end(), {
+		{ "", "" },
+		{ "Turn time limit", std::to_string(timer.getLimit()) + " ms" },
+		{ "Average turn time", std::to_string(timer.getAverageCalcTime()) + " ms" },
+		{ "Average number of simulations per turn", std::to_string(avgSimulationCount) + " sim/turn" },
+		{ "Average simulation/s speed", std::to_string(averageSpeedSimPerSec) + " sim/sec" },
+		{ "Search threads", std::to_string(getThreadCount()) },
+		{ "Simulation/s speed per thread", getSimsPerSecPerThread() },
+		{ "Average re-root time", std::to_string(getAverageReRootTime()) + " ms" },
+		{ "Peak tree size", std::to_string(getPeakNodeCount()) + " nodes" },
+		{ "Evicted subtrees", std::to_string(getEvictedSubtreeCount()) },
+		{ "Average compaction time", std::to_string(getAverageCompactionTime()) + " ms" },
+		{ "Cache misses per iteration", getCacheMissesPerIteration() },
+		{ "L1 data read misses per iteration", getL1MissesPerIteration() },
+		{ "Node storage pages", getNodeStoragePages() },
+	});
+}
+
 double MCTSAgentBase::getAvgSimulationCount() const {
 	assert(timer.getTotalNumberOfCals() != 0);
-	return double(simulationCount) / timer.getTotalNumberOfCals();
+	return double(getTotalSimulationCount()) / timer.getTotalNumberOfCals();
+}
+
+long long MCTSAgentBase::getTotalSimulationCount() const {
+	long long result = simulationCount;
+	for (const auto& worker : workers)
+		result += worker->simulationCount;
+	return result;
+}
+
+int MCTSAgentBase::getThreadCount() const {
+	return threadCount;
+}
+
+/* workers search for the turns of this agent, so all speeds are over its total calculation time */
+std::string MCTSAgentBase::getSimsPerSecPerThread() const {
+	std::string result = std::to_string(std::lround(simulationCount * 1000.0 / timer.getTotalCalcTime()));
+	for (const auto& worker : workers)
+		result += ", " + std::to_string(std::lround(worker->simulationCount * 1000.0 / timer.getTotalCalcTime()));
+	return result + " sim/sec";
+}
+
+int MCTSAgentBase::getNodeCount() const {
+	return nodes.size();
+}
+
+int MCTSAgentBase::getPeakNodeCount() const {
+	return peakNodeCount;
+}
+
+int MCTSAgentBase::getEvictedSubtreeCount() const {
+	return evictedSubtreeCount;
+}
+
+double MCTSAgentBase::getAverageCompactionTime() const {
+	return compactionTimer.getTotalNumberOfCals() ? compactionTimer.getAverageCalcTime() : 0;
+}
+
+std::string MCTSAgentBase::getCacheMissesPerIteration() const {
+	long long misses = cacheMissCount, iterations = countedIterations;
+	for (const auto& worker : workers)
+		misses += worker->cacheMissCount, iterations += worker->countedIterations;
+	return perIteration(countCacheMisses, hasCacheMissCounts, misses, iterations);
+}
+
+std::string MCTSAgentBase::getL1MissesPerIteration() const {
+	long long misses = l1MissCount, iterations = countedIterations;
+	for (const auto& worker : workers)
+		misses += worker->l1MissCount, iterations += worker->countedIterations;
+	return perIteration(countCacheMisses, hasL1MissCounts, misses, iterations);
+}
+
+std::string MCTSAgentBase::getNodeStoragePages() const {
+	return Pages::describe(pageMode, numaLocal, nodes.get_allocator().hasFallenBack()
+		|| compactArena.get_allocator().hasFallenBack());
+}
+
+int MCTSAgentBase::getLeafThreadCount() const {
+	return playoutPool ? playoutPool->getThreadCount() : 0;
+}
+
+double MCTSAgentBase::getAverageReRootTime() const {
+	return reRootTimer.getTotalNumberOfCals() ? reRootTimer.getAverageCalcTime() : 0;
 }
@@ -3,65 +3,274 @@
 
 #include "Agent.hpp"
 #include "State.hpp"
+#include "Move.hpp"
+#include "PerfCounter.hpp"
+#include "PageAllocator.hpp"
+#include "PlayoutPool.hpp"
+#include "AMAFTable.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <string>
 
 class MCTSAgentBase : public Agent {
 public:
 	using param_t = Agent::param_t;
 	using reward_t = State::reward_t;
+	using index_t = std::uint32_t;
 
 protected:
-	struct MCTSNode {
-		MCTSNode(const up<State>& initialState);
-		MCTSNode(up<State>&& initialState);
+	static constexpr index_t NO_NODE = ~index_t(0);
+
+	template<class T>
+	using NodeStorage = std::vector<T, PageAllocator<T>>;
 
+	/*
+	 * Fixed-size node record kept in the nodes arena and linked by indices.
+	 * Children of a node are the contiguous range starting at firstChild,
+	 * reserved when the node is expanded for the first time, the first
+	 * expandedCount of them have been expanded. A child gets its move when
+	 * it is expanded, drawn uniformly from the untried moves mask the node
+	 * holds a slot of until it is fully expanded, so no move list is built
+	 * or shuffled. The turn and terminal flag are copied from the state on
+	 * expansion, so they can be read in state-less mode, where only the
+	 * root has a state. The statistics of a node are nodeScores and
+	 * nodeVisits at its index, so those of a child range are contiguous.
+	 */
+	struct MCTSNode {
 		bool isTerminal() const;
 		bool shouldExpand() const;
-		int expandGetIdx();
-
-		virtual sp<MCTSNode> makeChildFromState(up<State>&& state) = 0;
-		void addReward(reward_t agentPlayingReward, AgentID whoIsPlaying);
-		sp<Action> getBestAction();
-		up<State> cloneState();
-		bool operator<(const MCTSNode& o) const;
+		void setFromState(const State& state);
+		up<State> cloneState() const;
 
 		up<State> state;
-		wp<MCTSNode> parent;
-		std::vector<sp<MCTSNode>> children;
-		std::vector<sp<Action>> actions;
-		int nextActionToResolveIdx = 0;
-		
-		struct MCTSNodeStats {
-			reward_t score = 0;
-			int visits = 0;
-		} stats;
+		index_t parent = NO_NODE;
+		index_t firstChild = NO_NODE;
+		index_t untriedSlot = NO_NODE;
+		std::uint16_t childCount = 0;
+		std::uint16_t expandedCount = 0;
+		move_t move = 0;
+		std::int8_t turn = NONE;
+		bool terminal = false;
 	};
 
 public:
-	MCTSAgentBase(AgentID id, double calcLimitInMs, up<MCTSNode>&& root);
+	MCTSAgentBase(AgentID id, double calcLimitInMs, const up<State>& initialState,
+		const AgentArgs& args);
+	~MCTSAgentBase();
 
 	sp<Action> getAction(const up<State> &state) override;
 	void recordAction(const sp<Action> &action) override;
 	double getAvgSimulationCount() const override;
+	long long getTotalSimulationCount() const;
+	int getThreadCount() const;
+	std::string getSimsPerSecPerThread() const;
+	int getNodeCount() const;
+	double getAverageReRootTime() const;
+	int getPeakNodeCount() const;
+	int getEvictedSubtreeCount() const;
+	double getAverageCompactionTime() const;
+	std::string getCacheMissesPerIteration() const;
+	std::string getL1MissesPerIteration() const;
+	std::string getNodeStoragePages() const;
+	int getLeafThreadCount() const;
 
 protected:
-	virtual sp<MCTSNode> treePolicy();
-	virtual sp<MCTSNode> expand(const sp<MCTSNode>& node);
-	int expandGetIdx(const sp<MCTSNode>& node);
-	virtual sp<MCTSNode> select(const sp<MCTSNode>& node);
-	int selectGetIdx(const sp<MCTSNode>& node);
-	virtual param_t eval(const sp<MCTSNode>& node, const sp<Action>& action) = 0;
-	virtual void defaultPolicy(const sp<MCTSNode>& initialNode) = 0;
-	virtual void backup(sp<MCTSNode> node) = 0;
+	/* the rows of getDesc every agent of the base reports, after its title */
+	void appendBaseDesc(std::vector<KeyValue>& desc, double avgSimulationCount) const;
+	/* an agent of the same class with args, searching its own tree from rootState */
+	virtual up<MCTSAgentBase> createWorker(const up<State>& rootState, const AgentArgs& args) const = 0;
+	void search(const CalcTimer& turnTimer);
+	virtual index_t treePolicy();
+	virtual index_t expand(index_t node);
+	index_t expandGetIdx(index_t node);
+	virtual index_t select(index_t node);
+	index_t selectGetIdx(index_t node);
+	index_t selectUCT(index_t node, param_t exploreFactor,
+		const param_t* blendWeights=nullptr, const param_t* blendValues=nullptr) const;
+	index_t selectRAVE(index_t node, param_t exploreFactor);
+	param_t evalRAVE(index_t node, param_t exploreFactor);
+	virtual param_t eval(index_t node) = 0;
+	virtual void defaultPolicy(index_t initialNode) = 0;
+	virtual void backup(index_t node) = 0;
 	virtual void postWork();
 
+	index_t allocateNodes(int count);
+	void releaseNodes(index_t first, int count);
+	void releaseSubtree(index_t node);
+	void discardChildren(index_t node);
+	void reclaimNodes(int budget);
+	bool isOverNodeBudget() const;
+	void evictColdSubtrees();
+	void coalesceFreeRanges();
+	void compactTree();
+	void usePlayoutPool(const AgentArgs& args);
+	void rejectLeafPlayouts(const AgentArgs& args, const std::string& agentName) const;
+	void useAMAF();
+	AMAFTable::NodeStats getNodeActionsStats(index_t node);
+	void createChildren(index_t node, const State& state);
+	void releaseUntriedSlot(MCTSNode& node);
+	MoveMask getChildMoves(index_t node) const;
+	void addReward(index_t node, reward_t agentPlayingReward, AgentID whoIsPlaying, int playouts=1);
+	void randomPlayouts(State& state);
+	void prefetchChildren(index_t node) const;
+	void prefetchAncestor(int depth) const;
+	sp<Action> getBestAction() const;
+
+	State& beginRollout(index_t node);
+	void play(State& state, move_t move);
+	void endRollout();
+
 protected:
-	sp<MCTSNode> root;
+	/*
+	 * Node arena. Ranges discarded by re-rooting in recordAction are kept
+	 * in freeRanges by their length and handed out again by allocateNodes.
+	 * The storage is passed on to the next agent created on the same
+	 * thread, so GameRunner reuses one arena across the games it plays.
+	 * Nodes and their statistics are on the pages of pageMode (hugePages
+	 * arg: 0 default, 1 transparent, 2 explicit huge pages), with
+	 * numaLocal on the NUMA node of the thread that builds the tree.
+	 */
+	PageMode pageMode;
+	bool numaLocal;
+	NodeStorage<MCTSNode> nodes;
+	NodeStorage<reward_t> nodeScores;
+	NodeStorage<int> nodeVisits;
+	std::vector<std::vector<index_t>> freeRanges;
+	std::vector<MoveMask> untriedMoves;
+	std::vector<index_t> freeUntriedSlots;
+	index_t root;
 	int maxAgentCount;
 	std::vector<reward_t> agentRewards;
 
 	int timesTreeDescended;
 	int simulationCount = 0;
 	int currentSimulationCount;
+
+	/*
+	 * Number of random playouts run from the selected leaf in one
+	 * iteration (State::randomPlayouts), agentRewards then hold their sums
+	 * and playoutCount tells backup how many visits to add. With leafThreads
+	 * they are split between the search thread and a playoutPool of that
+	 * many threads. Only agents whose defaultPolicy plays through
+	 * randomPlayouts call usePlayoutPool, the others rejectLeafPlayouts.
+	 */
+	int batchPlayouts;
+	int playoutCount = 1;
+	up<PlayoutPool> playoutPool;
+
+	/*
+	 * In undo search mode a single search state is walked down the tree
+	 * during treePolicy and the playout, and rolled back with State::undo
+	 * afterwards, instead of cloning a rollout state on every iteration.
+	 */
+	bool undoSearch;
+	up<State> searchState;
+	up<State> rolloutState;
+	std::vector<PlayedMove> playedMoves;
+
+	/*
+	 * In state-less mode nodes below the root keep only their move and
+	 * statistics, the state of a node is the undo search state after
+	 * treePolicy descended to it (state-less mode implies undo search).
+	 */
+	bool statelessNodes;
+
+	/* selectUCT scores four children at once with AVX2 when the CPU has it */
+	bool simdSelect;
+
+	/*
+	 * AMAF statistics of the RAVE agents, who call useAMAF. selectRAVE
+	 * blends the UCT value of every child with the AMAF value of its move
+	 * in the parent by beta = sqrt(K / (3 n + K)). A node gets AMAF stats
+	 * on the first backup through it once it has children and
+	 * raveMinVisits visits (16 by default), until then its children are
+	 * evaluated by UCT alone. Released and compacted nodes take their AMAF
+	 * stats along.
+	 */
+	param_t KFactor;
+	int raveMinVisits;
+	up<AMAFTable> actionsAMAF;
+	std::vector<param_t> blendWeights;
+	std::vector<param_t> blendValues;
+
+	/*
+	 * Child ranges discarded by recordAction wait here and are freed by
+	 * reclaimNodes, at most reclaimBudget expanded records after every
+	 * iteration, so re-rooting costs the same however big the tree is.
+	 * A budget of 0 frees them before recordAction returns.
+	 */
+	struct ReclaimRange {
+		index_t first;
+		int count;
+		int expandedCount;
+	};
+	std::vector<ReclaimRange> reclaimQueue;
+	int reclaimBudget;
+	CalcTimer reRootTimer;
+
+	/*
+	 * With a nodeBudget (in node records, 0 for none) the tree stops
+	 * growing at the budget: evictColdSubtrees collapses the least visited
+	 * subtrees into their roots, whose statistics already hold everything
+	 * backed up through them, until a quarter of the budget is free again.
+	 * A node that cannot get children within the budget stays a leaf.
+	 * stuckLiveNodeCount is the live count left by the last pass that
+	 * could not reach its target, -1 if it did.
+	 */
+	int nodeBudget;
+	int liveNodeCount = 0;
+	int stuckLiveNodeCount = -1;
+	int peakNodeCount = 0;
+	int evictedSubtreeCount = 0;
+	std::vector<index_t> evictStack;
+
+	/*
+	 * With compactTree the tree left after re-rooting on the agent's own
+	 * move (while the opponent is thinking) is copied breadth-first into
+	 * compactArena, which then becomes the arena: every child range lands
+	 * right after the ranges of the level above, in the order descent
+	 * reaches them, and nothing is left on the free lists.
+	 */
+	bool compactTreeAfterMove;
+	NodeStorage<MCTSNode> compactArena;
+	std::vector<index_t> newIndices;
+	CalcTimer compactionTimer;
+
+	/*
+	 * With a prefetchDistance treePolicy prefetches the statistics and
+	 * records of the children of every node it descends to while the move
+	 * to it is played, and backup, walking up descentPath, prefetches the
+	 * node prefetchDistance levels above the one it updates. 0, the
+	 * default, turns both off. With countCacheMisses the search loop of
+	 * getAction is measured by hardware counters, reported per iteration
+	 * by getDesc.
+	 */
+	int prefetchDistance;
+	std::vector<index_t> descentPath;
+	bool countCacheMisses;
+	bool hasCacheMissCounts = false;
+	bool hasL1MissCounts = false;
+	long long cacheMissCount = 0;
+	long long l1MissCount = 0;
+	long long countedIterations = 0;
+
+	/*
+	 * Root parallelization: with threads > 1 the agent keeps threads - 1
+	 * workers, single-threaded agents of its own class with their own
+	 * trees, created on the first getAction. Each turn every worker
+	 * searches on a thread of its own, with its own random stream, until
+	 * the turn timer of this agent runs out, and getBestAction sums the
+	 * root children of all trees by move. recordAction re-roots them all.
+	 * Workers get no playout pool, and a pool of the agent would only serve
+	 * one of the threads, so threads and leafThreads don't combine.
+	 */
+	int threadCount;
+	AgentArgs workerArgs;
+	std::vector<up<MCTSAgentBase>> workers;
+
+private:
+	static thread_local std::vector<NodeStorage<MCTSNode>> spareArenas;
 };
 
 #endif /* MCTS_AGENT_BASE_HPP */
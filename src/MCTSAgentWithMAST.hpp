@@ -2,13 +2,14 @@
 #define MCTS_AGENT_WITH_MAST_HPP
 
 #include "MCTSAgentBase.hpp"
+#include "MASTPolicy.hpp"
 #include "State.hpp"
 
 class MCTSAgentWithMAST : public MCTSAgentBase {
 public:
 	using param_t = MCTSAgentBase::param_t;
 	using reward_t = MCTSAgentBase::reward_t;
-	using MCTSNodeBase = MCTSAgentBase::MCTSNode;
+	using index_t = MCTSAgentBase::index_t;
 
 	MCTSAgentWithMAST(AgentID id, double calcLimitInMs,
 		const up<State> &initialState, const AgentArgs& args);
@@ -16,38 +17,20 @@ public:
 	std::vector<KeyValue> getDesc(double avgSimulationCount=0) const override;
 
 protected:
-	struct MCTSNode : public MCTSNodeBase {
-		MCTSNode(const up<State>& initialState);
-		MCTSNode(up<State>&& initialState);
+	up<MCTSAgentBase> createWorker(const up<State>& rootState, const AgentArgs& args) const override;
 
-		sp<MCTSNodeBase> makeChildFromState(up<State>&& state) override;
-	};
+	index_t expand(index_t node) override;
+	index_t select(index_t node) override;
+	param_t eval(index_t node) override;
 
-	struct MASTActionStats {
-		reward_t score = 0;
-		int times = 0;
-	};
-
-	sp<MCTSNodeBase> expand(const sp<MCTSNodeBase>& node) override;
-	sp<MCTSNodeBase> select(const sp<MCTSNodeBase>& node) override;
-	param_t eval(const sp<MCTSNodeBase>& node, const sp<Action>& action) override;
-
-	void defaultPolicy(const sp<MCTSNodeBase>& initialNode) override;
-	sp<Action> getActionWithDefaultPolicy(const up<State>& state);
-	void backup(sp<MCTSNodeBase> node) override;
-	void MASTPolicy();
-	inline void updateActionStat(AgentID id, int actionIdx);
+	void defaultPolicy(index_t initialNode) override;
+	void backup(index_t node) override;
 
 	void postWork() override;
 
 private:
 	param_t exploreFactor;
-	param_t epsilon;
-	param_t decayFactor;
-
-	int maxActionCount;
-	std::vector<std::vector<MASTActionStats>> actionsStats;
-	std::vector<std::pair<AgentID, int>> actionHistory;
+	MASTPolicy mast;
 	int defaultPolicyLength;
 };
 
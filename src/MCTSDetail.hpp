@@ -0,0 +1,116 @@
+#ifndef MCTS_DETAIL_HPP
+#define MCTS_DETAIL_HPP
+
+#include "Common.hpp"
+#include "Agent.hpp"
+#include "State.hpp"
+#include "Move.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Pieces shared by the search cores templated on the game type (MCTS,
+ * ParallelMCTS, TranspositionMCTS) and by their Agent adapters, so the
+ * cores only differ in how they keep and reach their nodes.
+ */
+namespace mcts_detail {
+	using reward_t = State::reward_t;
+	using param_t = Agent::param_t;
+	using index_t = std::uint32_t;
+
+	/* plays randomly until the result is decided, returns the reward of AGENT1 */
+	template<class game_t>
+	reward_t rollout(game_t& state) {
+		while (!state.isDecided())
+			state.apply(Random::choice(state.getValidMovesMask()));
+		return state.getReward(AGENT1);
+	}
+
+	/* nodes are valued for the agent who moved into them, the root for the one who did not move next */
+	inline reward_t eval(reward_t agent1Reward, int mover) {
+		return mover == AGENT1 ? agent1Reward : 1 - agent1Reward;
+	}
+
+	template<class game_t>
+	int getRootMover(const game_t& rootState) {
+		return rootState.getTurn() ^ 1;
+	}
+
+	/* UCT value of a child of mean reward meanScore explored visits times below a parent of parentLogVisits */
+	inline param_t uct(param_t meanScore, int visits, param_t parentLogVisits, param_t exploreFactor) {
+		return meanScore + exploreFactor * std::sqrt(2.0 * parentLogVisits / visits);
+	}
+
+	/* the first index of [first, end) of the greatest value(index), the range is not empty */
+	template<class value_t>
+	index_t argmax(index_t first, index_t end, value_t value) {
+		index_t best = first;
+		param_t bestValue = value(first);
+		for (index_t i = first + 1; i < end; ++i) {
+			const param_t curValue = value(i);
+			if (curValue > bestValue)
+				bestValue = curValue, best = i;
+		}
+		return best;
+	}
+
+	/*
+	 * Copies the subtree of newRoot from nodes to kept in breadth-first
+	 * order and returns the number of nodes copied. Every child range lands
+	 * right after the ranges of the level above. A node record has
+	 * firstChild (at least noChildren when there are none), childCount and
+	 * parent, and its assignment copies the whole record. kept has room for
+	 * the whole subtree.
+	 */
+	template<class nodes_t, class kept_t>
+	index_t keepSubtree(const nodes_t& nodes, kept_t& kept, index_t newRoot, index_t noChildren) {
+		index_t keptCount = 0;
+		kept[keptCount++] = nodes[newRoot];
+		kept[0].parent = ~index_t(0);
+
+		for (index_t i = 0; i < keptCount; ++i) {
+			const index_t oldFirstChild = kept[i].firstChild;
+			if (oldFirstChild >= noChildren)
+				continue;
+			kept[i].firstChild = keptCount;
+			for (index_t c = 0; c < kept[i].childCount; ++c) {
+				kept[keptCount] = nodes[oldFirstChild + c];
+				kept[keptCount++].parent = i;
+			}
+		}
+		return keptCount;
+	}
+
+	/* the State handed to an adapter is known to be a game_t, it is cast without RTTI */
+	template<class game_t>
+	const game_t& asGame(const up<State>& state) {
+		return static_cast<const game_t&>(*state);
+	}
+
+	/*
+	 * getDesc of an adapter: title, the rows of the turn timer and the
+	 * simulation speed, searchRows, then exploreFactor and paramRows.
+	 */
+	inline std::vector<KeyValue> describeSearch(const std::string& title, const CalcTimer& timer,
+			long long simulationCount, double avgSimulationCount, param_t exploreFactor,
+			const std::vector<KeyValue>& searchRows={}, const std::vector<KeyValue>& paramRows={}) {
+		int averageSpeedSimPerSec = std::round((simulationCount * 1000.0) / timer.getTotalCalcTime());
+		std::vector<KeyValue> desc { { title, "" },
+			{ "", "" },
+			{ "Turn time limit", std::to_string(timer.getLimit()) + " ms" },
+			{ "Average turn time", std::to_string(timer.getAverageCalcTime()) + " ms" },
+			{ "Average number of simulations per turn", std::to_string(avgSimulationCount) + " sim/turn" },
+			{ "Average simulation/s speed", std::to_string(averageSpeedSimPerSec) + " sim/sec" },
+		};
+		desc.insert(desc.end(), searchRows.begin(), searchRows.end());
+		desc.push_back({ "", "" });
+		desc.push_back({ "Exploration speed constant (C) in UCT policy", std::to_string(exploreFactor) });
+		desc.insert(desc.end(), paramRows.begin(), paramRows.end());
+		return desc;
+	}
+}
+
+#endif /* MCTS_DETAIL_HPP */
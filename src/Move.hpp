@@ -0,0 +1,232 @@
+#ifndef MOVE_HPP
+#define MOVE_HPP
+
+#include "Common.hpp"
+
+#include <cstdint>
+#include <cassert>
+
+/*
+ * Compact move representation used by the allocation-free State API.
+ * A move is the Action::getIdx() of the corresponding action.
+ */
+using move_t = std::uint8_t;
+constexpr int MAX_MOVE_COUNT = 256;
+
+/*
+ * What State::undo needs besides the move to restore the position it was
+ * played from, read with State::getUndoInfo before the move is applied.
+ * The caller keeps it with the move on the path it walks, so the state
+ * holds no history and stays as small as the position itself.
+ */
+using undo_t = std::int8_t;
+
+struct PlayedMove {
+	move_t move;
+	undo_t undoInfo;
+};
+
+class MoveMask {
+public:
+	class const_iterator {
+	public:
+		const_iterator(const MoveMask& mask, int wordIdx);
+
+		move_t operator*() const;
+		const_iterator& operator++();
+		bool operator!=(const const_iterator& o) const;
+
+	private:
+		void skipEmptyWords();
+
+		const MoveMask& mask;
+		int wordIdx;
+		std::uint64_t bits;
+	};
+
+	void set(int move);
+	void reset(int move);
+	bool test(int move) const;
+	void setBits(int offset, std::uint64_t bits);
+
+	int count() const;
+	/* number of moves of the mask below move */
+	int rank(int move) const;
+	bool empty() const;
+	move_t select(int k) const;
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+private:
+	static int selectBit(std::uint64_t word, int k);
+
+	static constexpr int WORD_BITS = 64;
+	static constexpr int WORD_COUNT = MAX_MOVE_COUNT / WORD_BITS;
+	std::uint64_t words[WORD_COUNT] = {};
+};
+
+struct MoveList {
+	void clear();
+	void push(move_t move);
+	int size() const;
+	bool empty() const;
+	move_t operator[](int idx) const;
+
+	move_t* begin();
+	move_t* end();
+	const move_t* begin() const;
+	const move_t* end() const;
+
+	move_t moves[MAX_MOVE_COUNT];
+	int count = 0;
+};
+
+namespace Random {
+	move_t choice(const MoveMask& moves);
+	move_t choice(const MoveList& moves);
+}
+
+inline MoveMask::const_iterator::const_iterator(const MoveMask& mask, int wordIdx) :
+	mask(mask), wordIdx(wordIdx), bits(wordIdx < WORD_COUNT ? mask.words[wordIdx] : 0) {
+	skipEmptyWords();
+}
+
+inline move_t MoveMask::const_iterator::operator*() const {
+	return move_t(wordIdx * WORD_BITS + __builtin_ctzll(bits));
+}
+
+inline MoveMask::const_iterator& MoveMask::const_iterator::operator++() {
+	bits &= bits - 1;
+	skipEmptyWords();
+	return *this;
+}
+
+inline bool MoveMask::const_iterator::operator!=(const const_iterator& o) const {
+	return wordIdx != o.wordIdx || bits != o.bits;
+}
+
+inline void MoveMask::const_iterator::skipEmptyWords() {
+	while (!bits && wordIdx < WORD_COUNT)
+		if (++wordIdx < WORD_COUNT)
+			bits = mask.words[wordIdx];
+}
+
+inline void MoveMask::set(int move) {
+	assert(0 <= move && move < MAX_MOVE_COUNT);
+	words[move / WORD_BITS] |= std::uint64_t(1) << (move % WORD_BITS);
+}
+
+inline void MoveMask::reset(int move) {
+	assert(0 <= move && move < MAX_MOVE_COUNT);
+	words[move / WORD_BITS] &= ~(std::uint64_t(1) << (move % WORD_BITS));
+}
+
+inline bool MoveMask::test(int move) const {
+	assert(0 <= move && move < MAX_MOVE_COUNT);
+	return words[move / WORD_BITS] >> (move % WORD_BITS) & 1;
+}
+
+inline void MoveMask::setBits(int offset, std::uint64_t bits) {
+	const int wordIdx = offset / WORD_BITS, shift = offset % WORD_BITS;
+	words[wordIdx] |= bits << shift;
+	if (shift && wordIdx + 1 < WORD_COUNT)
+		words[wordIdx + 1] |= bits >> (WORD_BITS - shift);
+}
+
+inline int MoveMask::count() const {
+	int result = 0;
+	for (const auto word : words)
+		result += __builtin_popcountll(word);
+	return result;
+}
+
+inline int MoveMask::rank(int move) const {
+	assert(0 <= move && move < MAX_MOVE_COUNT);
+	const int wordIdx = move / WORD_BITS;
+	int result = __builtin_popcountll(words[wordIdx] & ((std::uint64_t(1) << (move % WORD_BITS)) - 1));
+	for (int i = 0; i < wordIdx; ++i)
+		result += __builtin_popcountll(words[i]);
+	return result;
+}
+
+inline bool MoveMask::empty() const {
+	for (const auto word : words)
+		if (word)
+			return false;
+	return true;
+}
+
+inline move_t MoveMask::select(int k) const {
+	assert(0 <= k && k < count());
+	for (int i = 0; i < WORD_COUNT; ++i) {
+		const int wordCount = __builtin_popcountll(words[i]);
+		if (k < wordCount)
+			return move_t(i * WORD_BITS + selectBit(words[i], k));
+		k -= wordCount;
+	}
+	assert(false);
+	return 0;
+}
+
+inline int MoveMask::selectBit(std::uint64_t word, int k) {
+	while (k--)
+		word &= word - 1;
+	return __builtin_ctzll(word);
+}
+
+inline MoveMask::const_iterator MoveMask::begin() const {
+	return const_iterator(*this, 0);
+}
+
+inline MoveMask::const_iterator MoveMask::end() const {
+	return const_iterator(*this, WORD_COUNT);
+}
+
+inline void MoveList::clear() {
+	count = 0;
+}
+
+inline void MoveList::push(move_t move) {
+	assert(count < MAX_MOVE_COUNT);
+	moves[count++] = move;
+}
+
+inline int MoveList::size() const {
+	return count;
+}
+
+inline bool MoveList::empty() const {
+	return count == 0;
+}
+
+inline move_t MoveList::operator[](int idx) const {
+	assert(0 <= idx && idx < count);
+	return moves[idx];
+}
+
+inline move_t* MoveList::begin() {
+	return moves;
+}
+
+inline move_t* MoveList::end() {
+	return moves + count;
+}
+
+inline const move_t* MoveList::begin() const {
+	return moves;
+}
+
+inline const move_t* MoveList::end() const {
+	return moves + count;
+}
+
+inline move_t Random::choice(const MoveMask& moves) {
+	return moves.select(rand(moves.count()));
+}
+
+inline move_t Random::choice(const MoveList& moves) {
+	return moves[rand(moves.size())];
+}
+
+#endif /* MOVE_HPP */
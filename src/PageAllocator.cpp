@@ -0,0 +1,93 @@
+#include "PageAllocator.hpp"
+#include "Common.hpp"
+
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace {
+	bool isMapped(std::size_t size, PageMode mode, bool numaLocal) {
+		return (mode != PageMode::DEFAULT || numaLocal) && size >= Pages::HUGE_PAGE_SIZE;
+	}
+
+	std::size_t roundToHugePages(std::size_t size) {
+		return (size + Pages::HUGE_PAGE_SIZE - 1) / Pages::HUGE_PAGE_SIZE * Pages::HUGE_PAGE_SIZE;
+	}
+
+#ifdef __linux__
+	/* transparent huge pages only back huge page aligned ranges, so the slack around one is unmapped */
+	void* mapAligned(std::size_t size) {
+		const std::size_t mappedSize = size + Pages::HUGE_PAGE_SIZE;
+		void* mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapped == MAP_FAILED)
+			return nullptr;
+		const auto first = reinterpret_cast<std::uintptr_t>(mapped);
+		const auto aligned = roundToHugePages(first);
+		if (aligned > first)
+			munmap(mapped, aligned - first);
+		munmap(reinterpret_cast<void*>(aligned + size), first + mappedSize - aligned - size);
+		return reinterpret_cast<void*>(aligned);
+	}
+#endif
+}
+
+void* Pages::allocate(std::size_t size, PageMode mode, bool numaLocal, bool& fellBack) {
+	if (!isMapped(size, mode, numaLocal))
+		return ::operator new(size);
+#ifdef __linux__
+	size = roundToHugePages(size);
+	void* block = nullptr;
+	if (mode == PageMode::EXPLICIT) {
+		block = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (block == MAP_FAILED) {
+			block = nullptr;
+			fellBack = true;
+		}
+	}
+	if (!block) {
+		block = mapAligned(size);
+		if (!block)
+			throw std::bad_alloc();
+		if (mode != PageMode::DEFAULT)
+			madvise(block, size, MADV_HUGEPAGE);
+	}
+	if (numaLocal)
+		syscall(SYS_mbind, block, size, MPOL_LOCAL, nullptr, 0, 0);
+	return block;
+#else
+	return ::operator new(size);
+#endif
+}
+
+void Pages::deallocate(void* block, std::size_t size, PageMode mode, bool numaLocal) {
+#ifdef __linux__
+	if (isMapped(size, mode, numaLocal)) {
+		munmap(block, roundToHugePages(size));
+		return;
+	}
+#endif
+	::operator delete(block);
+}
+
+std::string Pages::describe(PageMode mode, bool numaLocal, bool fellBack) {
+	std::string result = mode == PageMode::EXPLICIT ? "explicit huge pages" :
+		mode == PageMode::TRANSPARENT ? "transparent huge pages" : "default pages";
+	if (mode == PageMode::EXPLICIT && fellBack)
+		result += " (fell back to transparent)";
+	if (numaLocal)
+		result += ", NUMA node local";
+	return result;
+}
+
+PageMode Pages::parseMode(int hugePages) {
+	if (hugePages < int(PageMode::DEFAULT) || hugePages > int(PageMode::EXPLICIT))
+		errorExit("hugePages has to be 0 (default), 1 (transparent) or 2 (explicit huge pages)");
+	return PageMode(hugePages);
+}
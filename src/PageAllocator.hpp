@@ -0,0 +1,97 @@
+#ifndef PAGE_ALLOCATOR_HPP
+#define PAGE_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+/*
+ * Pages behind blocks of at least a huge page: TRANSPARENT maps them
+ * aligned to huge pages and asks the kernel to back them with transparent
+ * huge pages (madvise), EXPLICIT takes them from the reserved huge page
+ * pool (MAP_HUGETLB) and falls back to TRANSPARENT when the pool cannot
+ * serve the block. With numaLocal the block is bound to the NUMA node of
+ * the thread that first touches its pages, whatever the process policy.
+ * Smaller blocks and DEFAULT without numaLocal come from operator new.
+ * A PageAllocator and the copies and rebinds made from it share one
+ * fellBack flag, set when one of their EXPLICIT blocks fell back, so an
+ * agent reports the pages of its own storage.
+ */
+enum class PageMode {
+	DEFAULT,
+	TRANSPARENT,
+	EXPLICIT
+};
+
+namespace Pages {
+	constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20;
+
+	/* sets fellBack when an EXPLICIT block had to fall back to TRANSPARENT */
+	void* allocate(std::size_t size, PageMode mode, bool numaLocal, bool& fellBack);
+	void deallocate(void* block, std::size_t size, PageMode mode, bool numaLocal);
+	/* the mode and, for EXPLICIT, whether a block had to fall back */
+	std::string describe(PageMode mode, bool numaLocal, bool fellBack=false);
+	/* the mode of a hugePages arg, which is 0, 1 or 2 */
+	PageMode parseMode(int hugePages);
+}
+
+template<class T>
+class PageAllocator {
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	PageAllocator(PageMode mode=PageMode::DEFAULT, bool numaLocal=false);
+	template<class U>
+	PageAllocator(const PageAllocator<U>& other);
+
+	T* allocate(std::size_t n);
+	void deallocate(T* block, std::size_t n);
+	bool hasFallenBack() const;
+
+	PageMode mode;
+	bool numaLocal;
+	std::shared_ptr<bool> fellBack;
+};
+
+template<class T>
+PageAllocator<T>::PageAllocator(PageMode mode, bool numaLocal) :
+	mode(mode), numaLocal(numaLocal), fellBack(std::make_shared<bool>(false)) {
+}
+
+template<class T>
+template<class U>
+PageAllocator<T>::PageAllocator(const PageAllocator<U>& other) :
+	mode(other.mode), numaLocal(other.numaLocal), fellBack(other.fellBack) {
+}
+
+template<class T>
+T* PageAllocator<T>::allocate(std::size_t n) {
+	return static_cast<T*>(Pages::allocate(n * sizeof(T), mode, numaLocal, *fellBack));
+}
+
+template<class T>
+void PageAllocator<T>::deallocate(T* block, std::size_t n) {
+	Pages::deallocate(block, n * sizeof(T), mode, numaLocal);
+}
+
+template<class T>
+bool PageAllocator<T>::hasFallenBack() const {
+	return *fellBack;
+}
+
+template<class T, class U>
+bool operator==(const PageAllocator<T>& lhs, const PageAllocator<U>& rhs) {
+	return lhs.mode == rhs.mode && lhs.numaLocal == rhs.numaLocal;
+}
+
+template<class T, class U>
+bool operator!=(const PageAllocator<T>& lhs, const PageAllocator<U>& rhs) {
+	return !(lhs == rhs);
+}
+
+#endif /* PAGE_ALLOCATOR_HPP */
@@ -0,0 +1,369 @@
+#ifndef PARALLEL_MCTS_HPP
+#define PARALLEL_MCTS_HPP
+
+#include "Common.hpp"
+#include "Agent.hpp"
+#include "State.hpp"
+#include "Move.hpp"
+#include "MCTSDetail.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+ * Tree-parallel UCT search with random playouts: the threads of search
+ * descend, expand and back up one shared tree, like MCTS<game_t> does on
+ * one thread. Node statistics are atomics updated without locks, and a
+ * thread descending through a node adds virtualLoss visits without a
+ * reward to it, taken back in backup, so the threads descending at the
+ * same time spread over different lines. The children of a node are
+ * created by the thread that claims its firstChild with a CAS, the
+ * others treat the node as a leaf until the range is published. Then
+ * every expansion takes the next child slot with a fetch_add. Nodes live
+ * in an Arena of at most nodeCapacity records, whose chunks are allocated
+ * as the tree reaches them and never move while the threads read them.
+ * A claim takes its range only when the range fits, and a leaf whose
+ * children don't is marked ARENA_FULL and played out from then on, until
+ * advance frees the arena.
+ *
+ * This is tree parallelism for plain UCT only. The RAVE and MAST
+ * policies, the node budget, reclamation, compaction and page modes of
+ * MCTSAgentBase are not available here, MCTSAgentBase runs those on
+ * threads at the root (threads) or at the leaves (leafThreads).
+ */
+template<class game_t>
+class ParallelMCTS {
+public:
+	using reward_t = State::reward_t;
+	using param_t = Agent::param_t;
+	using index_t = std::uint32_t;
+
+	/* counters of one search thread, each on its own cache line so the threads don't share one */
+	struct alignas(64) ThreadCounters {
+		long long iterations = 0;
+		long long claimConflicts = 0;
+	};
+
+	ParallelMCTS(const game_t& rootState, param_t exploreFactor, int virtualLoss, index_t nodeCapacity) :
+		rootState(rootState), exploreFactor(exploreFactor), virtualLoss(virtualLoss),
+		nodeCapacity(nodeCapacity), nodes(nodeCapacity), keptNodes(nodeCapacity) {
+		resetTree();
+	}
+
+	/*
+	 * Runs iterations on threadCount threads, this one included, while the
+	 * timer has time left. The root gets its children first, so the threads
+	 * don't all start on one claim and there is a best move however short
+	 * the turn is.
+	 */
+	long long search(const CalcTimer& timer, int threadCount) {
+		threadCounters.resize(std::max<std::size_t>(threadCounters.size(), threadCount));
+		const long long iterationsBefore = getIterationCount();
+		if (nodes[ROOT].firstChild.load(std::memory_order_relaxed) == NO_NODE)
+			claimChildren(ROOT, rootState);
+		std::vector<std::thread> threads;
+		if (threadCount > 1) {
+			const auto seed = Random::rng();
+			for (int i = 1; i < threadCount; ++i)
+				threads.emplace_back([this, &timer, i, seed]() {
+					Random::seed(seed, i);
+					runIterations(timer, threadCounters[i]);
+				});
+		}
+		runIterations(timer, threadCounters[0]);
+		for (auto& thread : threads)
+			thread.join();
+		return getIterationCount() - iterationsBefore;
+	}
+
+	move_t getBestMove() const {
+		const auto& root = nodes[ROOT];
+		const index_t firstChild = root.firstChild.load(std::memory_order_relaxed);
+		assert(firstChild < nodeCapacity);
+		index_t best = firstChild;
+		for (index_t i = firstChild + 1; i < firstChild + getExpandedCount(root); ++i)
+			if (nodes[i].visits.load(std::memory_order_relaxed) > nodes[best].visits.load(std::memory_order_relaxed))
+				best = i;
+		return nodes[best].move;
+	}
+
+	/* makes the child reached by move the new root and keeps its subtree, no search may be running */
+	void advance(move_t move) {
+		const auto& root = nodes[ROOT];
+		const index_t firstChild = root.firstChild.load(std::memory_order_relaxed);
+		index_t newRoot = NO_NODE;
+		for (index_t i = 0; firstChild < nodeCapacity && i < getExpandedCount(root); ++i)
+			if (nodes[firstChild + i].move == move)
+				newRoot = firstChild + i;
+
+		rootState.apply(move);
+		if (newRoot == NO_NODE)
+			resetTree();
+		else
+			keepSubtree(newRoot);
+	}
+
+	const game_t& getRootState() const {
+		return rootState;
+	}
+
+	/* records allocated in the arena the tree is in */
+	std::size_t getAllocatedNodeCount() const {
+		return nodes.getAllocatedCount();
+	}
+
+	int getNodeCount() const {
+		return nodeCount.load(std::memory_order_relaxed);
+	}
+
+	long long getIterationCount() const {
+		long long result = 0;
+		for (const auto& counters : threadCounters)
+			result += counters.iterations;
+		return result;
+	}
+
+	const std::vector<ThreadCounters>& getThreadCounters() const {
+		return threadCounters;
+	}
+
+private:
+	static constexpr index_t ROOT = 0;
+	static constexpr index_t NO_NODE = ~index_t(0);
+	static constexpr index_t CLAIMED = NO_NODE - 1;
+	static constexpr index_t ARENA_FULL = NO_NODE - 2;
+	static constexpr int CHUNK_BITS = 14;
+	static constexpr index_t CHUNK_SIZE = index_t(1) << CHUNK_BITS;
+	static constexpr index_t CHUNK_MASK = CHUNK_SIZE - 1;
+
+	/*
+	 * firstChild is NO_NODE, CLAIMED while its claimer creates the children,
+	 * ARENA_FULL if they did not fit, or the published range, whose records are complete once it is read.
+	 * The fields after it are written before the node is published.
+	 */
+	struct Node {
+		/* rewards of the agent who played move */
+		std::atomic<reward_t> score;
+		std::atomic<int> visits;
+		std::atomic<index_t> firstChild;
+		std::atomic<std::uint16_t> expandedCount;
+		std::uint16_t childCount;
+		index_t parent;
+		move_t move;
+		std::int8_t mover;
+
+		/* copies the record while no search is running */
+		Node& operator=(const Node& other) {
+			score.store(other.score.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			visits.store(other.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			firstChild.store(other.firstChild.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			expandedCount.store(other.expandedCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			childCount = other.childCount;
+			parent = other.parent;
+			move = other.move;
+			mover = other.mover;
+			return *this;
+		}
+	};
+
+	/*
+	 * Up to capacity node records in chunks of CHUNK_SIZE, allocated by
+	 * reserve when a range first reaches them. Records never move, so a
+	 * reader only needs the chunk pointer published before the range that
+	 * made reserve allocate it. Threads racing to allocate one chunk
+	 * publish it with a CAS, the losers free theirs.
+	 */
+	class Arena {
+	public:
+		explicit Arena(index_t capacity) :
+			chunkCount((std::size_t(capacity) + CHUNK_SIZE - 1) >> CHUNK_BITS),
+			chunks(new std::atomic<Node*>[chunkCount]()) {
+
+		}
+
+		~Arena() {
+			for (std::size_t i = 0; i < chunkCount; ++i)
+				delete[] chunks[i].load(std::memory_order_relaxed);
+		}
+
+		Node& operator[](index_t i) const {
+			return chunks[i >> CHUNK_BITS].load(std::memory_order_relaxed)[i & CHUNK_MASK];
+		}
+
+		/* allocates the chunks of the records [first, first + count) that are not yet */
+		void reserve(index_t first, index_t count) {
+			for (std::size_t i = first >> CHUNK_BITS; i <= (first + count - 1) >> CHUNK_BITS; ++i) {
+				if (chunks[i].load(std::memory_order_acquire))
+					continue;
+				Node* chunk = new Node[CHUNK_SIZE];
+				Node* expected = nullptr;
+				if (!chunks[i].compare_exchange_strong(expected, chunk, std::memory_order_acq_rel))
+					delete[] chunk;
+			}
+		}
+
+		std::size_t getAllocatedCount() const {
+			std::size_t result = 0;
+			for (std::size_t i = 0; i < chunkCount; ++i)
+				if (chunks[i].load(std::memory_order_relaxed))
+					result += CHUNK_SIZE;
+			return result;
+		}
+
+		void swap(Arena& other) {
+			std::swap(chunkCount, other.chunkCount);
+			chunks.swap(other.chunks);
+		}
+
+	private:
+		std::size_t chunkCount;
+		std::unique_ptr<std::atomic<Node*>[]> chunks;
+	};
+
+	void runIterations(const CalcTimer& timer, ThreadCounters& counters) {
+		while (timer.isTimeLeft()) {
+			game_t state = rootState;
+			const index_t leaf = treePolicy(state, counters);
+			backup(leaf, mcts_detail::rollout(state));
+			++counters.iterations;
+		}
+	}
+
+	index_t treePolicy(game_t& state, ThreadCounters& counters) {
+		index_t node = ROOT;
+		addVirtualLoss(node);
+		while (!state.isTerminal()) {
+			auto& current = nodes[node];
+			index_t firstChild = current.firstChild.load(std::memory_order_acquire);
+			if (firstChild == NO_NODE)
+				firstChild = claimChildren(node, state);
+			if (firstChild == CLAIMED)
+				++counters.claimConflicts;
+			if (firstChild >= ARENA_FULL)
+				return node;
+			if (current.expandedCount.load(std::memory_order_relaxed) < current.childCount) {
+				const index_t slot = current.expandedCount.fetch_add(1, std::memory_order_relaxed);
+				if (slot < current.childCount) {
+					node = firstChild + slot;
+					addVirtualLoss(node);
+					state.apply(nodes[node].move);
+					return node;
+				}
+			}
+			node = select(current, firstChild);
+			addVirtualLoss(node);
+			state.apply(nodes[node].move);
+		}
+		return node;
+	}
+
+	/* the range of the children if this thread created them, CLAIMED if another one is, ARENA_FULL if they don't fit */
+	index_t claimChildren(index_t node, const game_t& state) {
+		index_t expected = NO_NODE;
+		if (!nodes[node].firstChild.compare_exchange_strong(expected, CLAIMED, std::memory_order_acquire))
+			return expected;
+
+		thread_local MoveList moves;
+		moves.clear();
+		for (const auto move : state.getValidMovesMask())
+			moves.push(move);
+		index_t firstChild = nodeCount.load(std::memory_order_relaxed);
+		do {
+			if (firstChild + moves.size() > nodeCapacity) {
+				nodes[node].firstChild.store(ARENA_FULL, std::memory_order_relaxed);
+				return ARENA_FULL;
+			}
+		} while (!nodeCount.compare_exchange_weak(firstChild, firstChild + moves.size(), std::memory_order_relaxed));
+
+		nodes.reserve(firstChild, moves.size());
+		std::shuffle(moves.begin(), moves.end(), Random::rng);
+		for (int i = 0; i < moves.size(); ++i)
+			initNode(nodes[firstChild + i], node, moves[i], state.getTurn());
+		nodes[node].childCount = moves.size();
+		nodes[node].firstChild.store(firstChild, std::memory_order_release);
+		return firstChild;
+	}
+
+	index_t select(const Node& node, index_t firstChild) const {
+		const param_t logVisits = std::log(node.visits.load(std::memory_order_relaxed));
+		return mcts_detail::argmax(firstChild, firstChild + node.childCount,
+			[this, logVisits](index_t i) { return eval(nodes[i], logVisits); });
+	}
+
+	/* a child taken by an expansion that has not added its virtual loss yet is tried first */
+	param_t eval(const Node& node, param_t parentLogVisits) const {
+		const int visits = node.visits.load(std::memory_order_relaxed);
+		if (visits == 0)
+			return std::numeric_limits<param_t>::infinity();
+		return mcts_detail::uct(node.score.load(std::memory_order_relaxed) / visits, visits,
+			parentLogVisits, exploreFactor);
+	}
+
+	void backup(index_t node, reward_t agent1Reward) {
+		for (; node != NO_NODE; node = nodes[node].parent) {
+			auto& current = nodes[node];
+			addScore(current.score, mcts_detail::eval(agent1Reward, current.mover));
+			current.visits.fetch_add(1 - virtualLoss, std::memory_order_relaxed);
+		}
+	}
+
+	void addVirtualLoss(index_t node) {
+		nodes[node].visits.fetch_add(virtualLoss, std::memory_order_relaxed);
+	}
+
+	static void addScore(std::atomic<reward_t>& score, reward_t reward) {
+		reward_t current = score.load(std::memory_order_relaxed);
+		while (!score.compare_exchange_weak(current, current + reward, std::memory_order_relaxed));
+	}
+
+	index_t getExpandedCount(const Node& node) const {
+		return std::min(node.expandedCount.load(std::memory_order_relaxed), node.childCount);
+	}
+
+	static void initNode(Node& node, index_t parent, move_t move, int mover) {
+		node.score.store(0, std::memory_order_relaxed);
+		node.visits.store(0, std::memory_order_relaxed);
+		node.firstChild.store(NO_NODE, std::memory_order_relaxed);
+		node.expandedCount.store(0, std::memory_order_relaxed);
+		node.childCount = 0;
+		node.parent = parent;
+		node.move = move;
+		node.mover = mover;
+	}
+
+	void resetTree() {
+		nodes.reserve(ROOT, 1);
+		initNode(nodes[ROOT], NO_NODE, 0, mcts_detail::getRootMover(rootState));
+		nodeCount.store(1, std::memory_order_relaxed);
+	}
+
+	/* copies the subtree of newRoot in breadth-first order to the other arena, where full leaves may grow again */
+	void keepSubtree(index_t newRoot) {
+		keptNodes.reserve(ROOT, getNodeCount());
+		const index_t keptCount = mcts_detail::keepSubtree(nodes, keptNodes, newRoot, ARENA_FULL);
+		for (index_t i = 0; i < keptCount; ++i)
+			if (keptNodes[i].firstChild.load(std::memory_order_relaxed) == ARENA_FULL)
+				keptNodes[i].firstChild.store(NO_NODE, std::memory_order_relaxed);
+		nodes.swap(keptNodes);
+		nodeCount.store(keptCount, std::memory_order_relaxed);
+	}
+
+private:
+	game_t rootState;
+	param_t exploreFactor;
+	int virtualLoss;
+	index_t nodeCapacity;
+	Arena nodes;
+	Arena keptNodes;
+	std::atomic<index_t> nodeCount;
+	std::vector<ThreadCounters> threadCounters;
+};
+
+#endif /* PARALLEL_MCTS_HPP */
@@ -0,0 +1,66 @@
+#include "PerfCounter.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+PerfCounter::PerfCounter(Event event) {
+#ifdef __linux__
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	if (event == Event::CACHE_MISSES) {
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	}
+	else {
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	(void) event;
+#endif
+}
+
+PerfCounter::~PerfCounter() {
+#ifdef __linux__
+	if (fd != -1)
+		close(fd);
+#endif
+}
+
+bool PerfCounter::isAvailable() const {
+	return fd != -1;
+}
+
+void PerfCounter::start() {
+#ifdef __linux__
+	if (fd != -1)
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+/* the kernel keeps the total across stop and start, getCount is the total at the last stop */
+void PerfCounter::stop() {
+#ifdef __linux__
+	if (fd == -1)
+		return;
+	ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	long long value;
+	if (read(fd, &value, sizeof(value)) == sizeof(value))
+		count = value;
+#endif
+}
+
+long long PerfCounter::getCount() const {
+	return count;
+}
@@ -0,0 +1,32 @@
+#ifndef PERF_COUNTER_HPP
+#define PERF_COUNTER_HPP
+
+/*
+ * Hardware event counter of the calling thread (Linux perf_event_open),
+ * counting user space events between start and stop. Hosts without the
+ * counters (most virtual machines) leave it unavailable, and it then
+ * counts nothing.
+ */
+class PerfCounter {
+public:
+	enum class Event {
+		CACHE_MISSES,
+		L1D_READ_MISSES
+	};
+
+	PerfCounter(Event event);
+	~PerfCounter();
+	PerfCounter(const PerfCounter&) = delete;
+	PerfCounter& operator=(const PerfCounter&) = delete;
+
+	bool isAvailable() const;
+	void start();
+	void stop();
+	long long getCount() const;
+
+private:
+	int fd = -1;
+	long long count = 0;
+};
+
+#endif /* PERF_COUNTER_HPP */
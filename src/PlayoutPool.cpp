@@ -0,0 +1,74 @@
+#include "PlayoutPool.hpp"
+#include "Common.hpp"
+
+#include <algorithm>
+
+PlayoutPool::PlayoutPool(int threadCount) :
+	partRewards(threadCount + 1) {
+
+	const auto seed = Random::rng();
+	for (int i = 1; i <= threadCount; ++i)
+		threads.emplace_back(&PlayoutPool::work, this, i, seed);
+}
+
+PlayoutPool::~PlayoutPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workReady.notify_all();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void PlayoutPool::run(State& state, int count, reward_t* rewardSums) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->state = &state;
+		playoutCount = count;
+		pendingCount = threads.size();
+		++generation;
+	}
+	workReady.notify_all();
+	playPart(0);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		workDone.wait(lock, [this]() { return pendingCount == 0; });
+	}
+
+	for (const auto& rewards : partRewards)
+		for (int id = 0; id < int(rewards.size()); ++id)
+			rewardSums[id] += rewards[id];
+}
+
+int PlayoutPool::getThreadCount() const {
+	return threads.size();
+}
+
+void PlayoutPool::work(int part, std::uint64_t seed) {
+	Random::seed(seed, part);
+	int doneGeneration = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		workReady.wait(lock, [&]() { return stopping || generation != doneGeneration; });
+		if (stopping)
+			return;
+		doneGeneration = generation;
+		lock.unlock();
+		playPart(part);
+		lock.lock();
+		if (--pendingCount == 0)
+			workDone.notify_one();
+	}
+}
+
+/* part gets the playouts [count * part / parts, count * (part + 1) / parts) */
+void PlayoutPool::playPart(int part) {
+	const int partCount = partRewards.size();
+	const int first = playoutCount * part / partCount;
+	const int last = playoutCount * (part + 1) / partCount;
+	auto& rewards = partRewards[part];
+	rewards.assign(state->getAgentCount(), 0);
+	if (first < last)
+		state->clone()->randomPlayouts(last - first, rewards.data());
+}
@@ -0,0 +1,51 @@
+#ifndef PLAYOUT_POOL_HPP
+#define PLAYOUT_POOL_HPP
+
+#include "State.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Threads that play the random playouts of one leaf together (leaf
+ * parallelization). run splits the playouts between the calling thread
+ * and the pool, every thread plays its share from a clone of the state
+ * (State::randomPlayouts) into reward sums of its own, and run returns
+ * once all of them are added up. Between runs the pool threads sleep.
+ */
+class PlayoutPool {
+public:
+	using reward_t = State::reward_t;
+
+	explicit PlayoutPool(int threadCount);
+	~PlayoutPool();
+	PlayoutPool(const PlayoutPool&) = delete;
+	PlayoutPool& operator=(const PlayoutPool&) = delete;
+
+	/* adds the rewards of count random playouts from state, which is only cloned, to rewardSums */
+	void run(State& state, int count, reward_t* rewardSums);
+	int getThreadCount() const;
+
+private:
+	void work(int part, std::uint64_t seed);
+	void playPart(int part);
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	int generation = 0;
+	int pendingCount = 0;
+	bool stopping = false;
+
+	/* the run in progress, part 0 is played by the calling thread */
+	State* state = nullptr;
+	int playoutCount = 0;
+	std::vector<std::vector<reward_t>> partRewards;
+};
+
+#endif /* PLAYOUT_POOL_HPP */
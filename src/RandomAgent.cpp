@@ -8,9 +8,9 @@ RandomAgent::RandomAgent(AgentID id, double calcLimitInMs, const up<State>&, con
 }
 
 sp<Action> RandomAgent::getAction(const up<State>& state) {
-	auto validActions = state->getValidActions();
-	assert(!validActions.empty());
-	return Random::choice(validActions);
+	const auto validMoves = state->getValidMovesMask();
+	assert(!validMoves.empty());
+	return state->makeAction(Random::choice(validMoves));
 }
 
 std::vector<KeyValue> RandomAgent::getDesc(double) const {
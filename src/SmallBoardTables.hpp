@@ -0,0 +1,144 @@
+#ifndef SMALL_BOARD_TABLES_HPP
+#define SMALL_BOARD_TABLES_HPP
+
+#include "Agent.hpp"
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Compile-time lookup tables for a single 3x3 board. A board is encoded as
+ * two 9-bit occupancy masks (one per agent). Every property we need factors
+ * over a single mask, so the tables are indexed by one mask (2^9 entries)
+ * instead of the full 2^9 x 2^9 pair, and are generated by the compiler so
+ * there is no initialization at startup.
+ *
+ * Boards of other sizes (N x N with N * N <= 16, so a board still fits in
+ * mask_t) get their win lines generated at compile time as well; checks that
+ * take an N template argument use the tables for the 3x3 board and an
+ * unrolled scan of the win lines otherwise.
+ */
+namespace SmallBoard {
+	using mask_t = std::uint16_t;
+
+	constexpr int BOARD_SIZE = 3;
+	constexpr int CELL_COUNT = BOARD_SIZE * BOARD_SIZE;
+	constexpr int MASK_COUNT = 1 << CELL_COUNT;
+	constexpr mask_t FULL_MASK = MASK_COUNT - 1;
+
+	template<int N>
+	constexpr mask_t getFullMask() {
+		static_assert(N > 0 && N * N <= 16, "Board has to fit in mask_t");
+		return mask_t((1u << (N * N)) - 1);
+	}
+
+	/* rows, columns and both diagonals of an N x N board */
+	template<int N>
+	constexpr std::array<mask_t, 2 * N + 2> makeWinLines() {
+		std::array<mask_t, 2 * N + 2> lines {};
+		for (int i = 0; i < N; ++i) {
+			for (int j = 0; j < N; ++j) {
+				lines[i] |= 1 << (i * N + j);
+				lines[N + i] |= 1 << (j * N + i);
+			}
+			lines[2 * N] |= 1 << (i * N + i);
+			lines[2 * N + 1] |= 1 << (i * N + N - 1 - i);
+		}
+		return lines;
+	}
+
+	template<int N>
+	inline constexpr std::array<mask_t, 2 * N + 2> WIN_LINES_OF = makeWinLines<N>();
+
+	inline constexpr auto WIN_LINES = WIN_LINES_OF<BOARD_SIZE>;
+
+	struct MaskInfo {
+		/* the mask (as cells of one agent) contains a whole line */
+		bool line;
+		/* some line has no cell of the mask (as cells of the opponent) */
+		bool lineFree;
+		/* cells missing from the mask (as occupied cells of both agents) */
+		std::uint8_t emptyCount;
+		std::uint8_t emptyCells[CELL_COUNT];
+	};
+
+	struct Tables {
+		MaskInfo info[MASK_COUNT];
+	};
+
+	constexpr Tables makeTables() {
+		Tables tables {};
+		for (int mask = 0; mask < MASK_COUNT; ++mask) {
+			auto& info = tables.info[mask];
+			for (const auto line : WIN_LINES) {
+				if ((mask & line) == line)
+					info.line = true;
+				if ((mask & line) == 0)
+					info.lineFree = true;
+			}
+			for (int cell = 0; cell < CELL_COUNT; ++cell)
+				if (!(mask & (1 << cell)))
+					info.emptyCells[info.emptyCount++] = cell;
+		}
+		return tables;
+	}
+
+	inline constexpr Tables TABLES = makeTables();
+
+	template<int N = BOARD_SIZE>
+	constexpr bool isLine(mask_t mask) {
+		if constexpr (N == BOARD_SIZE)
+			return TABLES.info[mask].line;
+		else {
+			bool line = false;
+			for (const auto winLine : WIN_LINES_OF<N>)
+				line |= (mask & winLine) == winLine;
+			return line;
+		}
+	}
+
+	constexpr AgentID getWinner(mask_t agent1Cells, mask_t agent2Cells) {
+		return isLine(agent1Cells) ? AGENT1 : isLine(agent2Cells) ? AGENT2 : NONE;
+	}
+
+	constexpr bool isTerminal(mask_t agent1Cells, mask_t agent2Cells) {
+		return isLine(agent1Cells) || isLine(agent2Cells) ||
+			(agent1Cells | agent2Cells) == FULL_MASK;
+	}
+
+	template<int N = BOARD_SIZE>
+	constexpr mask_t getEmptyMask(mask_t agent1Cells, mask_t agent2Cells) {
+		return getFullMask<N>() & ~(agent1Cells | agent2Cells);
+	}
+
+	constexpr const MaskInfo& getEmptyCells(mask_t agent1Cells, mask_t agent2Cells) {
+		return TABLES.info[agent1Cells | agent2Cells];
+	}
+
+	/* some win line has no cell of the (opponent's) mask */
+	template<int N = BOARD_SIZE>
+	constexpr bool isLineFree(mask_t opponentCells) {
+		if constexpr (N == BOARD_SIZE)
+			return TABLES.info[opponentCells].lineFree;
+		else {
+			bool lineFree = false;
+			for (const auto winLine : WIN_LINES_OF<N>)
+				lineFree |= (opponentCells & winLine) == 0;
+			return lineFree;
+		}
+	}
+
+	constexpr bool isWinnable(mask_t ownCells, mask_t opponentCells) {
+		return !isTerminal(ownCells, opponentCells) && isLineFree(opponentCells);
+	}
+
+	static_assert(WIN_LINES[0] == 0007 && WIN_LINES[3] == 0111 &&
+		WIN_LINES[6] == 0421 && WIN_LINES[7] == 0124, "Win lines are broken");
+	static_assert(isLine(0124) && !isLine(0123), "Win line table is broken");
+	static_assert(isLine<4>(0x8421) && !isLine<4>(0x0777), "Win lines are broken");
+	static_assert(isLineFree<4>(0x0777) && !isLineFree<4>(0x8421 | 0x1248), "Win lines are broken");
+	static_assert(getEmptyCells(0777, 0).emptyCount == 0, "Empty cells table is broken");
+	static_assert(TABLES.info[0].emptyCount == CELL_COUNT, "Empty cells table is broken");
+}
+
+#endif /* SMALL_BOARD_TABLES_HPP */
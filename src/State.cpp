@@ -4,8 +4,35 @@ std::ostream& operator<<(std::ostream& out, const State& state) {
 	return state.print(out);
 }
 
+bool State::isDecided() const {
+	return isTerminal();
+}
+
 up<State> State::applyCopy(const sp<Action>& action) {
 	auto ptr = clone();
 	ptr->apply(action);
 	return ptr;
 }
+
+up<State> State::applyCopy(move_t move) {
+	auto ptr = clone();
+	ptr->apply(move);
+	return ptr;
+}
+
+void State::getValidMoves(MoveList& moves) const {
+	moves.clear();
+	for (const auto move : getValidMovesMask())
+		moves.push(move);
+}
+
+void State::randomPlayouts(int count, reward_t* rewardSums) {
+	const int agentCount = getAgentCount();
+	for (int i = 0; i < count; ++i) {
+		auto state = clone();
+		while (!state->isDecided())
+			state->apply(Random::choice(state->getValidMovesMask()));
+		for (int id = 0; id < agentCount; ++id)
+			rewardSums[id] += state->getReward(AgentID(id));
+	}
+}
@@ -4,25 +4,49 @@
 #include "Common.hpp"
 #include "Action.hpp"
 #include "Agent.hpp"
+#include "Move.hpp"
 
 class State {
 public:
 	using reward_t = double;
 
 	virtual bool isTerminal() const = 0;
+
+	/*
+	 * The result can no longer change whatever is played (e.g. a dead
+	 * draw), getReward already returns the final rewards. Rollouts stop
+	 * here instead of playing on until isTerminal().
+	 */
+	virtual bool isDecided() const;
 	virtual void apply(const sp<Action>& action) = 0;
+	virtual void apply(move_t move) = 0;
+	virtual undo_t getUndoInfo() const = 0;
+	virtual void undo(move_t move, undo_t undoInfo) = 0;
 	up<State> applyCopy(const sp<Action>& action);
+	up<State> applyCopy(move_t move);
 
 	virtual constexpr int getAgentCount() const = 0;
 	virtual constexpr int getActionCount() const = 0;
 
 	virtual std::vector<sp<Action>> getValidActions() = 0;
 	virtual bool isValid(const sp<Action>& action) const = 0;
+	virtual bool isValid(move_t move) const = 0;
+
+	virtual MoveMask getValidMovesMask() const = 0;
+	void getValidMoves(MoveList& moves) const;
+	virtual sp<Action> makeAction(move_t move) const = 0;
 
 	virtual up<State> clone() = 0;
 	virtual bool didWin(AgentID id) = 0;
 	virtual reward_t getReward(AgentID id) = 0;
 	virtual AgentID getTurn() const = 0;
+	virtual std::uint64_t hash() const = 0;
+
+	/*
+	 * Plays count uniformly random games from this state and adds the
+	 * rewards of every agent to rewardSums (getAgentCount() entries).
+	 */
+	virtual void randomPlayouts(int count, reward_t* rewardSums);
 
 	virtual std::ostream& print(std::ostream& out) const = 0;
 	friend std::ostream& operator<<(std::ostream& out, const State& state);
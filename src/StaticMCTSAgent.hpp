@@ -0,0 +1,47 @@
+#ifndef STATIC_MCTS_AGENT_HPP
+#define STATIC_MCTS_AGENT_HPP
+
+#include "Agent.hpp"
+#include "State.hpp"
+#include "MCTS.hpp"
+#include "MCTSDetail.hpp"
+
+/*
+ * Agent adapter over MCTS<game_t>, so GameRunner and CGRunner can drive the
+ * statically dispatched search.
+ */
+template<class game_t>
+class StaticMCTSAgent : public Agent {
+public:
+	StaticMCTSAgent(AgentID id, double calcLimitInMs,
+			const up<State>& initialState, const AgentArgs& args) :
+		Agent(id, calcLimitInMs),
+		exploreFactor(getOrDefault(args, "exploreFactor", 0.4)),
+		mcts(mcts_detail::asGame<game_t>(initialState), exploreFactor) {
+
+	}
+
+	sp<Action> getAction(const up<State>&) override {
+		timer.startCalculation();
+		simulationCount += mcts.search(timer);
+		const auto bestMove = mcts.getBestMove();
+		timer.stopCalculation();
+
+		return mcts.getRootState().makeAction(bestMove);
+	}
+
+	void recordAction(const sp<Action>& action) override {
+		mcts.advance(move_t(action->getIdx()));
+	}
+
+	std::vector<KeyValue> getDesc(double avgSimulationCount=0) const override {
+		return mcts_detail::describeSearch("MCTS Agent with UCT selection and random simulation policy, "
+			"statically dispatched on the game type.", timer, simulationCount, avgSimulationCount, exploreFactor);
+	}
+
+private:
+	param_t exploreFactor;
+	MCTS<game_t> mcts;
+};
+
+#endif /* STATIC_MCTS_AGENT_HPP */
@@ -13,8 +13,6 @@ using TicTacToeAction = TicTacToe::TicTacToeAction;
 
 TicTacToe::TicTacToe() {
 	PROFILE_FUNCTION();
-	for (int i = 0; i < BOARD_SIZE; ++i)
-		std::fill(board[i], board[i] + BOARD_SIZE, NONE);
 }
 
 TicTacToe::TicTacToeAction::TicTacToeAction(int row, int col) : row(row), col(col) {
@@ -24,71 +22,39 @@ TicTacToe::TicTacToeAction::TicTacToeAction(int row, int col) : row(row), col(co
 bool TicTacToe::isTerminal() const {
 	PROFILE_FUNCTION();
 
-	if (emptyCells == 0)
-		return true;
-	for (int i = 0; i < BOARD_SIZE; ++i)
-		if (isRowDone(i) || isColDone(i))
-			return true;
-	return isDiag1Done() || isDiag2Done();
+	return SmallBoard::isTerminal(cells[AGENT1], cells[AGENT2]);
 }
 
 void TicTacToe::apply(AgentID turn, const TicTacToeAction& action) {
 	PROFILE_FUNCTION();
 
 	assert(isLegal(action));
-	board[action.row][action.col] = turn;
-	--emptyCells;
+	assert(turn != NONE);
+	cells[turn] |= getCellBit(action.row, action.col);
 }
 
-bool TicTacToe::isRowDone(int row) const {
+void TicTacToe::undo(const TicTacToeAction& action) {
 	PROFILE_FUNCTION();
 
-	AgentID val =  board[row][0];
-	return val != NONE && 
-		std::all_of(board[row], board[row] + BOARD_SIZE,
-				  [&val](const AgentID& p){ return p == val; });
+	assert(isInRange(action.row) && isInRange(action.col));
+	assert(!isEmpty(action.row, action.col));
+	const mask_t clearMask = ~getCellBit(action.row, action.col);
+	cells[AGENT1] &= clearMask;
+	cells[AGENT2] &= clearMask;
 }
 
-bool TicTacToe::isColDone(int col) const {
-	PROFILE_FUNCTION();
-
-	AgentID val =  board[0][col];
-	if (val == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[i][col] != val)
-			return false;
-	return true;
-}
-
-bool TicTacToe::isDiag1Done() const {
+bool TicTacToe::isEmpty(int i, int j) const {
 	PROFILE_FUNCTION();
 
-	AgentID val = board[0][0];
-	if (val == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[i][i] != val)
-			return false;
-	return true;
+	return !((cells[AGENT1] | cells[AGENT2]) & getCellBit(i, j));
 }
 
-bool TicTacToe::isDiag2Done() const {
-	PROFILE_FUNCTION();
-
-	AgentID val = board[0][BOARD_SIZE - 1];
-	if (val == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[i][BOARD_SIZE - 1 - i] != val)
-			return false;
-	return true;
+const SmallBoard::MaskInfo& TicTacToe::getEmptyCells() const {
+	return SmallBoard::getEmptyCells(cells[AGENT1], cells[AGENT2]);
 }
 
-bool TicTacToe::isEmpty(int i, int j) const {
-	PROFILE_FUNCTION();
-
-	return board[i][j] == NONE;
+TicTacToe::mask_t TicTacToe::getCellBit(int row, int col) const {
+	return mask_t(1) << (row * BOARD_SIZE + col);
 }
 
 bool TicTacToe::isLegal(const TicTacToeAction& action) const {
@@ -108,17 +74,7 @@ bool TicTacToe::isInRange(int idx) const {
 AgentID TicTacToe::getWinner() const {
 	PROFILE_FUNCTION();
 
-	for (int i = 0; i < BOARD_SIZE; ++i) {
-		if (isRowDone(i))
-			return board[i][0];
-		if (isColDone(i))
-			return board[0][i];
-	}
-	if (isDiag1Done())
-		return board[0][0];
-	if (isDiag2Done())
-		return board[0][BOARD_SIZE - 1];
-	return NONE;
+	return SmallBoard::getWinner(cells[AGENT1], cells[AGENT2]);
 }
 
 void TicTacToe::printLineSep(std::ostream& out) const {
@@ -158,16 +114,12 @@ char TicTacToe::getCharAtTerminal(int row, int col) const {
 }
 
 char TicTacToe::convertSymbolAt(int row, int col) const {
-	const auto symbol = board[row][col];
-	switch (symbol) {
-		case AGENT1:
-			return 'X';
-		case AGENT2:
-			return 'O';
-		case NONE:
-			return ' ';
-	}
-	assert(false);
+	const auto bit = getCellBit(row, col);
+	if (cells[AGENT1] & bit)
+		return 'X';
+	if (cells[AGENT2] & bit)
+		return 'O';
+	return ' ';
 }
 
 bool TicTacToe::isOnDiag1(int row, int col) const {
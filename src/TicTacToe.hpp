@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "Agent.hpp"
+#include "SmallBoardTables.hpp"
 
 class TicTacToe {
 public:
@@ -17,6 +18,7 @@ public:
 
 	bool isTerminal() const;
 	void apply(AgentID turn, const TicTacToeAction& action);
+	void undo(const TicTacToeAction& action);
 
 	void printLineSep(std::ostream& out) const;
 	void printRow(std::ostream& out, int row) const;
@@ -25,19 +27,16 @@ public:
 
 	bool isLegal(const TicTacToeAction& action) const;
 	bool isEmpty(int i, int j) const;
+	const SmallBoard::MaskInfo& getEmptyCells() const;
 
 private:
-	static constexpr int BOARD_SIZE = 3;
-	static_assert(BOARD_SIZE > 0, "Board Size has to be positive");
-	AgentID board[BOARD_SIZE][BOARD_SIZE];
-
-	int emptyCells = BOARD_SIZE * BOARD_SIZE;
+	using mask_t = SmallBoard::mask_t;
 
-	bool isRowDone(int row) const;
-	bool isColDone(int col) const;
-	bool isDiag1Done() const;
-	bool isDiag2Done() const;
+	static constexpr int BOARD_SIZE = SmallBoard::BOARD_SIZE;
+	static_assert(BOARD_SIZE > 0, "Board Size has to be positive");
+	mask_t cells[2] = {};
 
+	inline mask_t getCellBit(int row, int col) const;
 	inline bool isInRange(int idx) const;
 
 	inline char getCharAt(int row, int col) const;
@@ -0,0 +1,433 @@
+#ifndef TRANSPOSITION_MCTS_HPP
+#define TRANSPOSITION_MCTS_HPP
+
+#include "Common.hpp"
+#include "Agent.hpp"
+#include "State.hpp"
+#include "Move.hpp"
+#include "MCTSDetail.hpp"
+#include "PageAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/*
+ * UCT search with random playouts over a graph of positions instead of a
+ * tree, like MCTS<game_t> otherwise. A node holds the statistics of one
+ * position (told apart by its 64-bit hash) however many move orders reach
+ * it, and the moves of a node are edges to their nodes, so the search
+ * graph is a DAG (moves only ever fill cells, positions don't repeat).
+ * Expanding an edge looks the position up in the transposition table and
+ * links the node found there, and the descent goes on through it, or
+ * adds a node for a new position, which is the leaf played out.
+ *
+ * A child is valued by the mean of its node, which gathers the playouts
+ * of every path to it, and explored by the visits of the edge, as a node
+ * has no single parent. Backup walks the path the descent took.
+ *
+ * The table has 2^tableBits buckets of BUCKET_SIZE entries, a cache line
+ * each, and every node holds one entry, so the table bounds the graph. A
+ * new position takes a free entry of its bucket with a new node, or the
+ * entry and the node record of the least visited node in it, but the
+ * root's or one on the current path. Its edges go to free lists by their
+ * count. New edges take the shortest free range that holds them, and
+ * the rest of it goes back to the list of its length. Only when no range
+ * does are edges appended, up to as many as the game has moves for every
+ * table entry, and a node whose edges find no room is played out until
+ * some are freed. Edges keep the stamp of the node they link, which a
+ * reused record bumps, so an edge to a reused node is unlinked and is
+ * linked again through the table, tried first like a new one. When the bucket has no entry to give, the descent stops
+ * before the new position and plays it out from there. Nodes and edges
+ * are kept on the pages of hugePages, like the nodes of MCTSAgentBase.
+ */
+template<class game_t>
+class TranspositionMCTS {
+public:
+	using reward_t = State::reward_t;
+	using param_t = Agent::param_t;
+	using index_t = std::uint32_t;
+	using hash_t = std::uint64_t;
+
+	TranspositionMCTS(const game_t& rootState, param_t exploreFactor, int tableBits,
+			PageMode pageMode=PageMode::DEFAULT) :
+		nodes(PageAllocator<Node>(pageMode)), edges(nodes.get_allocator()),
+		keptNodes(nodes.get_allocator()), keptEdges(edges.get_allocator()),
+		rootState(rootState), exploreFactor(exploreFactor),
+		buckets(getBucketCount(tableBits)), bucketMask(buckets.size() - 1),
+		edgeCapacity(buckets.size() * BUCKET_SIZE * rootState.getActionCount()) {
+		resetGraph();
+	}
+
+	/* runs iterations while the timer has time left, returns their number */
+	int search(const CalcTimer& timer) {
+		int iterations = 0;
+		while (timer.isTimeLeft()) {
+			game_t state = rootState;
+			treePolicy(state);
+			backup(mcts_detail::rollout(state));
+			++iterations;
+		}
+		return iterations;
+	}
+
+	move_t getBestMove() const {
+		const auto& root = nodes[ROOT];
+		assert(root.expandedCount > 0);
+		const auto first = edges.begin() + root.firstEdge;
+		const auto best = std::max_element(first, first + root.expandedCount,
+			[](const Edge& e1, const Edge& e2){ return e1.visits < e2.visits; });
+		return best->move;
+	}
+
+	/* makes the node reached by move the new root and keeps the graph below it */
+	void advance(move_t move) {
+		const auto& root = nodes[ROOT];
+		index_t newRoot = NO_NODE;
+		for (index_t i = 0; i < root.expandedCount; ++i)
+			if (edges[root.firstEdge + i].move == move)
+				newRoot = getChild(edges[root.firstEdge + i]);
+
+		rootState.apply(move);
+		if (newRoot == NO_NODE)
+			resetGraph();
+		else
+			keepSubgraph(newRoot);
+	}
+
+	const game_t& getRootState() const {
+		return rootState;
+	}
+
+	int getNodeCount() const {
+		return nodes.size();
+	}
+
+	/* whether a block of the graph's storage fell back from explicit huge pages */
+	bool hasPagesFallenBack() const {
+		return nodes.get_allocator().hasFallenBack();
+	}
+
+	std::size_t getEdgeCount() const {
+		return edges.size();
+	}
+
+	/* expanded edges so far, and those of them linked to a node found in the table */
+	long long getExpansionCount() const {
+		return expansionCount;
+	}
+
+	long long getTranspositionCount() const {
+		return transpositionCount;
+	}
+
+	/* positions given a node so far, on a new record or a reused one */
+	long long getNewNodeCount() const {
+		return newNodeCount;
+	}
+
+	long long getReplacementCount() const {
+		return replacementCount;
+	}
+
+	std::size_t getTableEntryCount() const {
+		return buckets.size() * BUCKET_SIZE;
+	}
+
+private:
+	static constexpr index_t ROOT = 0;
+	static constexpr index_t NO_NODE = ~index_t(0);
+	static constexpr int BUCKET_SIZE = 4;
+	static constexpr int MIN_TABLE_BITS = 1;
+	static constexpr int MAX_TABLE_BITS = 30;
+
+	struct Node {
+		/* rewards of the agent who moved into the position */
+		reward_t score = 0;
+		int visits = 0;
+		hash_t hash = 0;
+		index_t firstEdge = NO_NODE;
+		/* bumped whenever the record is reused for another position */
+		std::uint32_t stamp = 0;
+		std::uint16_t edgeCount = 0;
+		std::uint16_t expandedCount = 0;
+		std::int8_t mover = NONE;
+	};
+
+	struct Edge {
+		index_t child = NO_NODE;
+		std::uint32_t childStamp = 0;
+		int visits = 0;
+		move_t move = 0;
+	};
+
+	template<class T>
+	using Storage = std::vector<T, PageAllocator<T>>;
+
+	struct TableEntry {
+		hash_t hash;
+		index_t node;
+	};
+
+	struct alignas(64) Bucket {
+		TableEntry entries[BUCKET_SIZE] = {
+			{ 0, NO_NODE }, { 0, NO_NODE }, { 0, NO_NODE }, { 0, NO_NODE } };
+	};
+
+	static std::size_t getBucketCount(int tableBits) {
+		if (tableBits < MIN_TABLE_BITS || tableBits > MAX_TABLE_BITS)
+			errorExit("tableBits has to be between " + std::to_string(MIN_TABLE_BITS)
+				+ " and " + std::to_string(MAX_TABLE_BITS));
+		return std::size_t(1) << tableBits;
+	}
+
+	/*
+	 * Descends to a new node, a terminal one, a node whose edges got no
+	 * room or an edge whose position got no node, the path taken is left
+	 * in nodePath and edgePath.
+	 */
+	void treePolicy(game_t& state) {
+		index_t node = ROOT;
+		nodePath.assign(1, ROOT);
+		edgePath.clear();
+		while (!state.isTerminal()) {
+			if (nodes[node].firstEdge == NO_NODE && !createEdges(node, state))
+				return;
+			auto& current = nodes[node];
+			const index_t edge = current.expandedCount < current.edgeCount
+				? current.firstEdge + current.expandedCount++ : select(current);
+			const int mover = state.getTurn();
+			state.apply(edges[edge].move);
+			edgePath.push_back(edge);
+
+			bool isNewNode = false;
+			index_t child = getChild(edges[edge]);
+			if (child == NO_NODE)
+				child = linkChild(edge, state, mover, isNewNode);
+			if (child == NO_NODE)
+				return;
+			nodePath.push_back(child);
+			if (isNewNode)
+				return;
+			node = child;
+		}
+	}
+
+	/* false when there is no room for the edges of node */
+	bool createEdges(index_t node, const game_t& state) {
+		moves.clear();
+		for (const auto move : state.getValidMovesMask())
+			moves.push(move);
+		std::shuffle(moves.begin(), moves.end(), Random::rng);
+
+		const int count = moves.size();
+		if (int(freeEdgeRanges.size()) <= count)
+			freeEdgeRanges.resize(count + 1);
+		index_t firstEdge = NO_NODE;
+		for (int length = count; length < int(freeEdgeRanges.size()); ++length)
+			if (auto& freeRanges = freeEdgeRanges[length]; !freeRanges.empty()) {
+				firstEdge = freeRanges.back();
+				freeRanges.pop_back();
+				if (length > count)
+					freeEdgeRanges[length - count].push_back(firstEdge + count);
+				break;
+			}
+		if (firstEdge == NO_NODE) {
+			if (edges.size() + count > edgeCapacity)
+				return false;
+			firstEdge = edges.size();
+			edges.resize(edges.size() + count);
+		}
+
+		nodes[node].firstEdge = firstEdge;
+		nodes[node].edgeCount = count;
+		for (int i = 0; i < count; ++i)
+			edges[firstEdge + i] = { NO_NODE, 0, 0, moves[i] };
+		return true;
+	}
+
+	/* the node edge leads to, NO_NODE if it is unlinked or the node was reused for another position */
+	index_t getChild(const Edge& edge) const {
+		return edge.child != NO_NODE && nodes[edge.child].stamp == edge.childStamp ? edge.child : NO_NODE;
+	}
+
+	/*
+	 * Links edge to the node of the position it leads to, found in the
+	 * table or a new one (then isNewNode is set), NO_NODE if the bucket of
+	 * the position has no entry to give. Visits the edge has from a node
+	 * since reused or dropped are not the new node's, they start over.
+	 */
+	index_t linkChild(index_t edge, const game_t& state, int mover, bool& isNewNode) {
+		++expansionCount;
+		const hash_t hash = state.hash();
+		index_t child = find(hash);
+		if (child != NO_NODE)
+			++transpositionCount;
+		else {
+			child = insert(hash);
+			if (child == NO_NODE)
+				return NO_NODE;
+			nodes[child].mover = mover;
+			isNewNode = true;
+		}
+		edges[edge].child = child;
+		edges[edge].childStamp = nodes[child].stamp;
+		edges[edge].visits = 0;
+		return child;
+	}
+
+	index_t select(const Node& node) const {
+		const param_t logVisits = std::log(node.visits);
+		return mcts_detail::argmax(node.firstEdge, node.firstEdge + node.edgeCount,
+			[this, logVisits](index_t i) { return eval(edges[i], logVisits); });
+	}
+
+	/* an unlinked edge is tried first, like one never expanded */
+	param_t eval(const Edge& edge, param_t parentLogVisits) const {
+		const index_t childIdx = getChild(edge);
+		if (childIdx == NO_NODE)
+			return std::numeric_limits<param_t>::infinity();
+		const auto& child = nodes[childIdx];
+		return mcts_detail::uct(child.score / child.visits, edge.visits, parentLogVisits, exploreFactor);
+	}
+
+	void backup(reward_t agent1Reward) {
+		for (const index_t node : nodePath) {
+			auto& current = nodes[node];
+			current.score += mcts_detail::eval(agent1Reward, current.mover);
+			++current.visits;
+		}
+		for (const index_t edge : edgePath)
+			++edges[edge].visits;
+	}
+
+	index_t find(hash_t hash) const {
+		for (const auto& entry : buckets[hash & bucketMask].entries)
+			if (entry.node != NO_NODE && entry.hash == hash)
+				return entry.node;
+		return NO_NODE;
+	}
+
+	/* the node of a new position, on a free entry or on the entry and record of a victim */
+	index_t insert(hash_t hash) {
+		auto& entries = buckets[hash & bucketMask].entries;
+		auto victim = std::find_if(std::begin(entries), std::end(entries),
+			[](const TableEntry& entry){ return entry.node == NO_NODE; });
+		index_t node = nodes.size();
+		if (victim == std::end(entries)) {
+			for (auto entry = std::begin(entries); entry != std::end(entries); ++entry)
+				if (!isOnPath(entry->node) && (victim == std::end(entries)
+						|| nodes[entry->node].visits < nodes[victim->node].visits))
+					victim = entry;
+			if (victim == std::end(entries))
+				return NO_NODE;
+			node = victim->node;
+			reuseNode(node);
+			++replacementCount;
+		}
+		else
+			nodes.emplace_back();
+		*victim = { hash, node };
+		nodes[node].hash = hash;
+		++newNodeCount;
+		return node;
+	}
+
+	/* the root is the first node of the path */
+	bool isOnPath(index_t node) const {
+		return std::find(nodePath.begin(), nodePath.end(), node) != nodePath.end();
+	}
+
+	void reuseNode(index_t node) {
+		auto& victim = nodes[node];
+		if (victim.firstEdge != NO_NODE)
+			freeEdgeRanges[victim.edgeCount].push_back(victim.firstEdge);
+		const std::uint32_t stamp = victim.stamp + 1;
+		victim = Node();
+		victim.stamp = stamp;
+	}
+
+	/* takes a free entry of the bucket of hash for node, false if there is none */
+	bool place(hash_t hash, index_t node) {
+		for (auto& entry : buckets[hash & bucketMask].entries)
+			if (entry.node == NO_NODE) {
+				entry = { hash, node };
+				return true;
+			}
+		return false;
+	}
+
+	void resetGraph() {
+		nodes.assign(1, Node());
+		nodes[ROOT].hash = rootState.hash();
+		nodes[ROOT].mover = mcts_detail::getRootMover(rootState);
+		edges.clear();
+		for (auto& ranges : freeEdgeRanges)
+			ranges.clear();
+		std::fill(buckets.begin(), buckets.end(), Bucket());
+		place(nodes[ROOT].hash, ROOT);
+	}
+
+	/*
+	 * Copies the nodes reachable from newRoot in breadth-first order,
+	 * keeping them shared. A node whose bucket is already full of nodes
+	 * kept closer to the root is dropped and its edges are unlinked.
+	 */
+	void keepSubgraph(index_t newRoot) {
+		keptNodes.clear();
+		keptEdges.clear();
+		newIndices.assign(nodes.size(), NO_NODE);
+		std::fill(buckets.begin(), buckets.end(), Bucket());
+		newIndices[newRoot] = ROOT;
+		keptNodes.push_back(nodes[newRoot]);
+		place(keptNodes[ROOT].hash, ROOT);
+
+		for (index_t i = 0; i < keptNodes.size(); ++i) {
+			const index_t oldFirstEdge = keptNodes[i].firstEdge;
+			if (oldFirstEdge == NO_NODE)
+				continue;
+			keptNodes[i].firstEdge = keptEdges.size();
+			for (index_t e = 0; e < keptNodes[i].edgeCount; ++e) {
+				Edge edge = edges[oldFirstEdge + e];
+				const index_t child = getChild(edge);
+				if (child != NO_NODE && newIndices[child] == NO_NODE && place(nodes[child].hash, keptNodes.size())) {
+					newIndices[child] = keptNodes.size();
+					keptNodes.push_back(nodes[child]);
+				}
+				edge.child = child == NO_NODE ? NO_NODE : newIndices[child];
+				keptEdges.push_back(edge);
+			}
+		}
+
+		nodes.swap(keptNodes);
+		edges.swap(keptEdges);
+		for (auto& ranges : freeEdgeRanges)
+			ranges.clear();
+	}
+
+private:
+	Storage<Node> nodes;
+	Storage<Edge> edges;
+	Storage<Node> keptNodes;
+	Storage<Edge> keptEdges;
+	/* free ranges of edges by their count, sized for every count created */
+	std::vector<std::vector<index_t>> freeEdgeRanges;
+	game_t rootState;
+	param_t exploreFactor;
+	std::vector<Bucket> buckets;
+	std::size_t bucketMask;
+	std::size_t edgeCapacity;
+	std::vector<index_t> nodePath;
+	std::vector<index_t> edgePath;
+	std::vector<index_t> newIndices;
+	MoveList moves;
+	long long expansionCount = 0;
+	long long transpositionCount = 0;
+	long long replacementCount = 0;
+	long long newNodeCount = 0;
+};
+
+#endif /* TRANSPOSITION_MCTS_HPP */
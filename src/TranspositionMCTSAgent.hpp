@@ -0,0 +1,80 @@
+#ifndef TRANSPOSITION_MCTS_AGENT_HPP
+#define TRANSPOSITION_MCTS_AGENT_HPP
+
+#include "Agent.hpp"
+#include "State.hpp"
+#include "TranspositionMCTS.hpp"
+#include "MCTSDetail.hpp"
+
+#include <cmath>
+
+/*
+ * Agent adapter over TranspositionMCTS<game_t>, with a transposition table
+ * of 2^tableBits buckets, which bounds the nodes of the graph.
+ */
+template<class game_t>
+class TranspositionMCTSAgent : public Agent {
+public:
+	TranspositionMCTSAgent(AgentID id, double calcLimitInMs,
+			const up<State>& initialState, const AgentArgs& args) :
+		Agent(id, calcLimitInMs),
+		exploreFactor(getOrDefault(args, "exploreFactor", 0.4)),
+		pageMode(Pages::parseMode(getOrDefault(args, "hugePages", 0))),
+		mcts(mcts_detail::asGame<game_t>(initialState), exploreFactor, getOrDefault(args, "tableBits", 16), pageMode) {
+
+	}
+
+	sp<Action> getAction(const up<State>&) override {
+		const long long expansionsBefore = mcts.getExpansionCount();
+		const long long transpositionsBefore = mcts.getTranspositionCount();
+		const long long nodesBefore = mcts.getNewNodeCount();
+
+		timer.startCalculation();
+		simulationCount += mcts.search(timer);
+		const auto bestMove = mcts.getBestMove();
+		timer.stopCalculation();
+
+		if (const long long expansions = mcts.getExpansionCount() - expansionsBefore)
+			transpositionShareSum += double(mcts.getTranspositionCount() - transpositionsBefore) / expansions;
+		++searchedMoveCount;
+		createdNodeCount += mcts.getNewNodeCount() - nodesBefore;
+		return mcts.getRootState().makeAction(bestMove);
+	}
+
+	void recordAction(const sp<Action>& action) override {
+		mcts.advance(move_t(action->getIdx()));
+	}
+
+	/* average over the moves searched of the share of expanded moves that reached a known position */
+	double getAverageTranspositionShare() const {
+		return searchedMoveCount ? transpositionShareSum / searchedMoveCount : 0;
+	}
+
+	double getNodesPerSec() const {
+		return createdNodeCount * 1000.0 / timer.getTotalCalcTime();
+	}
+
+	std::vector<KeyValue> getDesc(double avgSimulationCount=0) const override {
+		return mcts_detail::describeSearch("MCTS Agent with UCT selection and random simulation policy, "
+				"searching a graph of positions joined by a transposition table.",
+			timer, simulationCount, avgSimulationCount, exploreFactor,
+			{ { "Average new position/s speed", std::to_string(std::llround(getNodesPerSec())) + " nodes/sec" },
+				{ "Average share of expansions reaching a known position",
+					std::to_string(100 * getAverageTranspositionShare()) + "%" },
+				{ "Transposition table entries", std::to_string(mcts.getTableEntryCount()) },
+				{ "Graph nodes held", std::to_string(mcts.getNodeCount()) },
+				{ "Graph edges held", std::to_string(mcts.getEdgeCount()) },
+				{ "Transposition table replacements", std::to_string(mcts.getReplacementCount()) },
+				{ "Node storage pages", Pages::describe(pageMode, false, mcts.hasPagesFallenBack()) } });
+	}
+
+private:
+	param_t exploreFactor;
+	PageMode pageMode;
+	TranspositionMCTS<game_t> mcts;
+	double transpositionShareSum = 0;
+	int searchedMoveCount = 0;
+	long long createdNodeCount = 0;
+};
+
+#endif /* TRANSPOSITION_MCTS_AGENT_HPP */
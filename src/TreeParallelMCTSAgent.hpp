@@ -0,0 +1,68 @@
+#ifndef TREE_PARALLEL_MCTS_AGENT_HPP
+#define TREE_PARALLEL_MCTS_AGENT_HPP
+
+#include "Agent.hpp"
+#include "State.hpp"
+#include "ParallelMCTS.hpp"
+#include "MCTSDetail.hpp"
+
+#include <algorithm>
+
+/*
+ * Agent adapter over ParallelMCTS<game_t>, searching one shared tree on
+ * threads threads with plain UCT, of at most nodeCapacity nodes.
+ */
+template<class game_t>
+class TreeParallelMCTSAgent : public Agent {
+public:
+	TreeParallelMCTSAgent(AgentID id, double calcLimitInMs,
+			const up<State>& initialState, const AgentArgs& args) :
+		Agent(id, calcLimitInMs),
+		exploreFactor(getOrDefault(args, "exploreFactor", 0.4)),
+		threadCount(std::max(1, int(getOrDefault(args, "threads", 1)))),
+		virtualLoss(getOrDefault(args, "virtualLoss", 1)),
+		mcts(mcts_detail::asGame<game_t>(initialState), exploreFactor, virtualLoss,
+			getOrDefault(args, "nodeCapacity", 1 << 20)) {
+
+	}
+
+	sp<Action> getAction(const up<State>&) override {
+		timer.startCalculation();
+		simulationCount += mcts.search(timer, threadCount);
+		const auto bestMove = mcts.getBestMove();
+		timer.stopCalculation();
+
+		return mcts.getRootState().makeAction(bestMove);
+	}
+
+	void recordAction(const sp<Action>& action) override {
+		mcts.advance(move_t(action->getIdx()));
+	}
+
+	std::vector<KeyValue> getDesc(double avgSimulationCount=0) const override {
+		const double totalCalcTime = timer.getTotalCalcTime();
+		std::string speedPerThread;
+		long long claimConflicts = 0;
+		for (const auto& counters : mcts.getThreadCounters()) {
+			if (!speedPerThread.empty())
+				speedPerThread += ", ";
+			speedPerThread += std::to_string(std::llround((counters.iterations * 1000.0) / totalCalcTime));
+			claimConflicts += counters.claimConflicts;
+		}
+		return mcts_detail::describeSearch("MCTS Agent with UCT selection and random simulation policy, "
+				"searching one tree on many threads.", timer, simulationCount, avgSimulationCount, exploreFactor,
+			{ { "Search threads", std::to_string(threadCount) },
+				{ "Simulation/s speed per thread", speedPerThread + " sim/sec" },
+				{ "Expansions lost to another thread", std::to_string(claimConflicts) },
+				{ "Node records allocated", std::to_string(mcts.getAllocatedNodeCount()) } },
+			{ { "Virtual loss per descending thread", std::to_string(virtualLoss) } });
+	}
+
+private:
+	param_t exploreFactor;
+	int threadCount;
+	int virtualLoss;
+	ParallelMCTS<game_t> mcts;
+};
+
+#endif /* TREE_PARALLEL_MCTS_AGENT_HPP */
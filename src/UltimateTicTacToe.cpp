@@ -11,101 +11,121 @@ UltimateTicTacToeAction::UltimateTicTacToeAction(const AgentID& agentID, int row
 	agentID(agentID), row(row), col(col), action(action) {
 	PROFILE_FUNCTION();
 }
+
+UltimateTicTacToeAction::UltimateTicTacToeAction(int actionIdx) :
+	agentID(NONE),
+	row(actionIdx / (BOARD_SIZE * BOARD_SIZE * BOARD_SIZE)),
+	col(actionIdx % (BOARD_SIZE * BOARD_SIZE) / BOARD_SIZE),
+	action(actionIdx / (BOARD_SIZE * BOARD_SIZE) % BOARD_SIZE, actionIdx % BOARD_SIZE) {
+	PROFILE_FUNCTION();
+}
 						
 bool UltimateTicTacToe::isTerminal() const {
-	PROFILE_FUNCTION();
-
-	if (isAllTerminal())
-		return true;
-	for (int i = 0; i < BOARD_SIZE; ++i)
-		if (isRowDone(i) || isColDone(i))
-			return true;
-	return isDiag1Done() || isDiag2Done();
+	return terminal;
 }
 
-bool UltimateTicTacToe::isAllTerminal() const {
+void UltimateTicTacToe::apply(const sp<Action>& act) {
 	PROFILE_FUNCTION();
 
-	for (int i = 0; i < BOARD_SIZE; ++i)
-		if (!std::all_of(board[i], board[i] + BOARD_SIZE,
-					[](const auto& x){ return x.isTerminal(); }))
-			return false;
-	return true;
+	const auto& action = std::dynamic_pointer_cast<UltimateTicTacToeAction>(act);
+	assert(action);
+	assert(isLegal(action));
+	applyLegal(*action);
 }
 
-bool UltimateTicTacToe::isRowDone(int row) const {
+void UltimateTicTacToe::apply(move_t move) {
 	PROFILE_FUNCTION();
 
-	const auto winner = board[row][0].getWinner();
-	if (winner == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[row][i].getWinner() != winner)
-			return false;
-	return true;
+	const UltimateTicTacToeAction action(move);
+	assert(isLegal(action));
+	applyLegal(action);
 }
 
-bool UltimateTicTacToe::isColDone(int col) const {
-	PROFILE_FUNCTION();
-
-	const auto winner = board[0][col].getWinner();
-	if (winner == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[i][col].getWinner() != winner)
-			return false;
-	return true;
+/* the board the next move is forced to, -1 for any */
+undo_t UltimateTicTacToe::getUndoInfo() const {
+	return getLastBoard();
 }
 
-bool UltimateTicTacToe::isDiag1Done() const {
+void UltimateTicTacToe::undo(move_t move, undo_t undoInfo) {
 	PROFILE_FUNCTION();
 
-	const auto winner = board[0][0].getWinner();
-	if (winner == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[i][i].getWinner() != winner)
-			return false;
-	return true;
-}
+	const UltimateTicTacToeAction action(move);
+	board[action.row][action.col].undo(action.action);
+	turn = turn == AGENT1 ? AGENT2 : AGENT1;
 
-bool UltimateTicTacToe::isDiag2Done() const {
-	PROFILE_FUNCTION();
+	const mask_t boardBit = 1 << (action.row * BOARD_SIZE + action.col);
+	if (decided & boardBit) {
+		won[AGENT1] &= ~boardBit;
+		won[AGENT2] &= ~boardBit;
+		decided &= ~boardBit;
+		--decidedCount;
+	}
+	terminal = false;
+	winner = NONE;
 
-	const auto winner = board[0][BOARD_SIZE - 1].getWinner();
-	if (winner == NONE)
-		return false;
-	for (int i = 1; i < BOARD_SIZE; ++i)
-		if (board[i][BOARD_SIZE - 1 - i].getWinner() != winner)
-			return false;
-	return true;
+	zobristHash ^= Zobrist::KEYS.cells[turn][move] ^ Zobrist::KEYS.turn ^
+		Zobrist::getForcedBoardKey(getLastBoard());
+	const int lastBoard = undoInfo;
+	if (lastBoard == -1)
+		lastRow = lastCol = -1;
+	else
+		lastRow = lastBoard / BOARD_SIZE,
+		lastCol = lastBoard % BOARD_SIZE;
+	zobristHash ^= Zobrist::getForcedBoardKey(lastBoard);
 }
 
-void UltimateTicTacToe::apply(const sp<Action>& act) {
-	PROFILE_FUNCTION();
-
-	const auto& action = std::dynamic_pointer_cast<UltimateTicTacToeAction>(act);
-	assert(action);
-	assert(isLegal(action));
-
-	board[action->row][action->col].apply(turn, action->action);
+void UltimateTicTacToe::applyLegal(const UltimateTicTacToeAction& action) {
+	zobristHash ^= Zobrist::KEYS.cells[turn][action.getIdx()] ^ Zobrist::KEYS.turn ^
+		Zobrist::getForcedBoardKey(getLastBoard());
+	board[action.row][action.col].apply(turn, action.action);
+	updateMacroBoard(action.row, action.col);
 	turn = turn == AGENT1 ? AGENT2 : AGENT1;
 	
-	if (board[action->action.row][action->action.col].isTerminal())
+	if (board[action.action.row][action.action.col].isTerminal())
 		lastRow = lastCol = -1;
 	else
-		lastRow = action->action.row,
-		lastCol = action->action.col;
+		lastRow = action.action.row,
+		lastCol = action.action.col;
+	zobristHash ^= Zobrist::getForcedBoardKey(getLastBoard());
+}
+
+void UltimateTicTacToe::updateMacroBoard(int boardRow, int boardCol) {
+	const auto& cell = board[boardRow][boardCol];
+	if (!cell.isTerminal())
+		return;
+
+	const mask_t boardBit = 1 << (boardRow * BOARD_SIZE + boardCol);
+	decided |= boardBit;
+	++decidedCount;
+
+	const auto cellWinner = cell.getWinner();
+	if (cellWinner != NONE) {
+		won[cellWinner] |= boardBit;
+		if (SmallBoard::isLine(won[cellWinner])) {
+			terminal = true;
+			winner = cellWinner;
+		}
+	}
+	if (decidedCount == BOARD_SIZE * BOARD_SIZE)
+		terminal = true;
+}
+
+int UltimateTicTacToe::getLastBoard() const {
+	return lastRow == -1 ? -1 : lastRow * BOARD_SIZE + lastCol;
 }
 
 bool UltimateTicTacToe::isLegal(const sp<UltimateTicTacToeAction>& action) const {
+	return isLegal(*action);
+}
+
+bool UltimateTicTacToe::isLegal(const UltimateTicTacToeAction& action) const {
 	PROFILE_FUNCTION();
 
-	return canMove(action->agentID) &&
-		  isInRange(action->row) &&
-		  isInRange(action->col) &&
-		  properBoard(action->row, action->col) && 
-		  board[action->row][action->col].isLegal(action->action);
+	return canMove(action.agentID) &&
+		  isInRange(action.row) &&
+		  isInRange(action.col) &&
+		  properBoard(action.row, action.col) && 
+		  board[action.row][action.col].isLegal(action.action);
 }
 
 bool UltimateTicTacToe::canMove(AgentID agentID) const {
@@ -134,11 +154,11 @@ std::vector<sp<Action>> UltimateTicTacToe::getValidActions() {
 				const auto& cell = board[i][j];
 				if (cell.isTerminal())
 					continue;
-				for (int k = 0; k < BOARD_SIZE; ++k)
-					for (int l = 0; l < BOARD_SIZE; ++l)
-						if (cell.isEmpty(k, l))
-							validActions.push_back(std::mksh<UltimateTicTacToeAction>(
-								NONE, i, j, TicTacToe::TicTacToeAction(k, l)));
+				const auto& empty = cell.getEmptyCells();
+				for (int k = 0; k < empty.emptyCount; ++k)
+					validActions.push_back(std::mksh<UltimateTicTacToeAction>(
+						NONE, i, j, TicTacToe::TicTacToeAction(
+							empty.emptyCells[k] / BOARD_SIZE, empty.emptyCells[k] % BOARD_SIZE)));
 			}
 	}
 	else {
@@ -146,11 +166,11 @@ std::vector<sp<Action>> UltimateTicTacToe::getValidActions() {
 		if (cell.isTerminal())
 			return {};
 		assert(!cell.isTerminal());
-		for (int i = 0; i < BOARD_SIZE; ++i)
-			for (int j = 0; j < BOARD_SIZE; ++j)
-				if (cell.isEmpty(i, j))
-					validActions.push_back(std::mksh<UltimateTicTacToeAction>(
-						NONE, lastRow, lastCol, TicTacToe::TicTacToeAction(i, j)));
+		const auto& empty = cell.getEmptyCells();
+		for (int k = 0; k < empty.emptyCount; ++k)
+			validActions.push_back(std::mksh<UltimateTicTacToeAction>(
+				NONE, lastRow, lastCol, TicTacToe::TicTacToeAction(
+					empty.emptyCells[k] / BOARD_SIZE, empty.emptyCells[k] % BOARD_SIZE)));
 	}
 
 	return validActions;
@@ -162,6 +182,33 @@ bool UltimateTicTacToe::isValid(const sp<Action>& act) const {
 	return isLegal(action);
 }
 
+bool UltimateTicTacToe::isValid(move_t move) const {
+	return isLegal(UltimateTicTacToeAction(move));
+}
+
+MoveMask UltimateTicTacToe::getValidMovesMask() const {
+	PROFILE_FUNCTION();
+
+	MoveMask validMoves;
+	for (int i = 0; i < BOARD_SIZE; ++i)
+		for (int j = 0; j < BOARD_SIZE; ++j) {
+			const auto& cell = board[i][j];
+			if (!properBoard(i, j) || cell.isTerminal())
+				continue;
+			const auto& empty = cell.getEmptyCells();
+			for (int k = 0; k < empty.emptyCount; ++k)
+				validMoves.set(UltimateTicTacToeAction(
+					NONE, i, j, TicTacToe::TicTacToeAction(
+						empty.emptyCells[k] / BOARD_SIZE, empty.emptyCells[k] % BOARD_SIZE)).getIdx());
+		}
+
+	return validMoves;
+}
+
+sp<Action> UltimateTicTacToe::makeAction(move_t move) const {
+	return std::mksh<UltimateTicTacToeAction>(move);
+}
+
 bool UltimateTicTacToe::didWin(AgentID id) {
 	return id == getWinner();
 }
@@ -177,30 +224,9 @@ up<State> UltimateTicTacToe::clone() {
 	return up<State>(new UltimateTicTacToe(*this));
 }
 
-AgentID UltimateTicTacToe::getWinner() {
-	PROFILE_FUNCTION();
-	
-	if (isWinnerSet)
-		return winner;
-
-	for (int i = 0; i < BOARD_SIZE; ++i) {
-		if (isRowDone(i))
-			return setAndReturnWinner(board[i][0].getWinner());
-		if (isColDone(i))
-			return setAndReturnWinner(board[0][i].getWinner());
-	}
-	if (isDiag1Done())
-		return setAndReturnWinner(board[0][0].getWinner());
-	if (isDiag2Done())
-		return setAndReturnWinner(board[0][BOARD_SIZE - 1].getWinner());
-	assert(isAllTerminal());
-	return setAndReturnWinner(NONE);
-}
-
-AgentID UltimateTicTacToe::setAndReturnWinner(AgentID winner) {
-	assert(!isWinnerSet);
-	isWinnerSet = true;
-	return this->winner = winner;
+AgentID UltimateTicTacToe::getWinner() const {
+	assert(terminal);
+	return winner;
 }
 
 std::ostream& UltimateTicTacToe::print(std::ostream& out) const {
@@ -276,3 +302,7 @@ AgentID UltimateTicTacToe::getTurn() const {
 	assert(turn != NONE);
 	return turn;
 }
+
+std::uint64_t UltimateTicTacToe::hash() const {
+	return zobristHash;
+}
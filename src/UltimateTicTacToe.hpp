@@ -5,6 +5,9 @@
 #include "Action.hpp"
 #include "State.hpp"
 #include "TicTacToe.hpp"
+#include "Zobrist.hpp"
+
+#include <cstdint>
 
 class UltimateTicTacToe : public State {
 public:
@@ -13,6 +16,7 @@ public:
 	typedef struct UltimateTicTacToeAction : public Action {
 		UltimateTicTacToeAction(const AgentID& agentID, int row, int col,
 				const TicTacToe::TicTacToeAction& action);
+		explicit UltimateTicTacToeAction(int actionIdx);
 
 		bool equals(const sp<Action>& o) const override;
 		int getIdx() const override;
@@ -24,39 +28,47 @@ public:
 
 	bool isTerminal() const override;
 	void apply(const sp<Action>& act) override;
+	void apply(move_t move) override;
+	undo_t getUndoInfo() const override;
+	void undo(move_t move, undo_t undoInfo) override;
 
 	constexpr int getAgentCount() const override;
 	constexpr int getActionCount() const override;
 
 	std::vector<sp<Action>> getValidActions() override;
 	bool isValid(const sp<Action>& act) const override;
+	bool isValid(move_t move) const override;
+
+	MoveMask getValidMovesMask() const override;
+	sp<Action> makeAction(move_t move) const override;
 
 	up<State> clone() override;
 	bool didWin(AgentID id) override; 
 	reward_t getReward(AgentID id) override;
 	AgentID getTurn() const override;
+	std::uint64_t hash() const override;
 
 	std::ostream& print(std::ostream& out) const override;
 	std::string getWinnerName() override;
 
 	bool isLegal(const sp<UltimateTicTacToeAction>& action) const;
+	bool isLegal(const UltimateTicTacToeAction& action) const;
 	
 	static constexpr int BOARD_SIZE = 3;
 	static_assert(BOARD_SIZE > 0, "Board size has to be positive");
 
 private:
-	bool isAllTerminal() const;
-	bool isRowDone(int row) const;
-	bool isColDone(int col) const;
-	bool isDiag1Done() const;
-	bool isDiag2Done() const;
+	using mask_t = SmallBoard::mask_t;
 
 	bool isInRange(int idx) const;
 	bool canMove(AgentID agentID) const;
 	bool properBoard(int boardRow, int boardCol) const;
 
-	AgentID getWinner();
-	AgentID setAndReturnWinner(AgentID winner);
+	void applyLegal(const UltimateTicTacToeAction& action);
+	void updateMacroBoard(int boardRow, int boardCol);
+	int getLastBoard() const;
+
+	AgentID getWinner() const;
 
 	void printLineSep(std::ostream& out) const;
 	void printRow(std::ostream& out, int i) const;
@@ -66,8 +78,17 @@ private:
 	AgentID turn = AGENT1;
 	int lastRow = -1, lastCol = -1;
 
-	bool isWinnerSet = false;
-	AgentID winner;
+	/*
+	 * Macro-board status, updated incrementally by apply() and undo(),
+	 * so isTerminal/getWinner/getReward are O(1).
+	 */
+	mask_t won[2] = {};
+	mask_t decided = 0;
+	int decidedCount = 0;
+	bool terminal = false;
+	AgentID winner = NONE;
+
+	Zobrist::hash_t zobristHash = Zobrist::getInitialHash();
 };
 
 #endif /* ULTIMATE_TICTACTOE_HPP */
@@ -0,0 +1,52 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include "Common.hpp"
+#include "Move.hpp"
+
+#include <cstdint>
+
+/*
+ * Zobrist keys for position hashing, generated at compile time with
+ * Random::splitMix64 so every build (and the CodinGame one) hashes the same
+ * way.
+ * A position hash is the xor of the keys of the occupied cells (by agent),
+ * the key of the forced board (or of a free move) and the turn key when
+ * the second agent is to move.
+ */
+namespace Zobrist {
+	using hash_t = std::uint64_t;
+
+	constexpr int MAX_FORCED_BOARDS = 32;
+
+	struct Keys {
+		hash_t cells[2][MAX_MOVE_COUNT];
+		hash_t forcedBoard[MAX_FORCED_BOARDS + 1];
+		hash_t turn;
+	};
+
+	constexpr Keys makeKeys() {
+		Keys keys {};
+		hash_t seed = 0x5eedf00dcafe1234ULL;
+		for (auto& agentKeys : keys.cells)
+			for (auto& key : agentKeys)
+				key = Random::splitMix64(seed);
+		for (auto& key : keys.forcedBoard)
+			key = Random::splitMix64(seed);
+		keys.turn = Random::splitMix64(seed);
+		return keys;
+	}
+
+	inline constexpr Keys KEYS = makeKeys();
+
+	/* forcedBoard == -1 stands for a free move */
+	constexpr hash_t getForcedBoardKey(int forcedBoard) {
+		return KEYS.forcedBoard[forcedBoard + 1];
+	}
+
+	constexpr hash_t getInitialHash() {
+		return getForcedBoardKey(-1);
+	}
+}
+
+#endif /* ZOBRIST_HPP */
@@ -0,0 +1,1266 @@
+#include "Common.hpp"
+#include "State.hpp"
+#include "UltimateTicTacToe.hpp"
+#include "BitboardUltimateTicTacToe.hpp"
+#include "MCTSAgent.hpp"
+#include "MCTSAgentWithRAVE.hpp"
+#include "FlatMCTSAgent.hpp"
+#include "StaticMCTSAgent.hpp"
+#include "TreeParallelMCTSAgent.hpp"
+#include "TranspositionMCTSAgent.hpp"
+#include "MASTTable.hpp"
+#include "BitboardBatchRollout.hpp"
+
+#include <getopt.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <malloc.h>
+#include <mutex>
+#include <thread>
+
+double benchLimitInMs = 1000;
+double rssBudgetInMb = 768;
+/* atomic, playout pool threads allocate while the search thread does */
+std::atomic<long long> allocationCount { 0 };
+std::atomic<long long> allocatedBytes { 0 };
+/* mismatches found by checks, the exit status is non-zero if there are any */
+long long failedCheckCount = 0;
+
+/* kept out of line, inlined free() after an inlined new trips -Wmismatched-new-delete */
+__attribute__((noinline)) void* operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+struct Benchmark {
+	std::string name;
+	std::string desc;
+	std::function<void()> run;
+};
+
+double getElapsedMs(std::chrono::time_point<std::chrono::high_resolution_clock> since) {
+	auto now = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now - since).count() * 1e-6;
+}
+
+void printResult(const std::string& label, double value, const std::string& unit) {
+	std::cout << std::fixed << std::setprecision(0);
+	std::cout << "   " << std::left << std::setw(40) << label << std::right
+		<< std::setw(12) << value << " " << unit << '\n';
+}
+
+void printGain(const std::string& label, double baseline, double value) {
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "   " << std::left << std::setw(40) << label << std::right
+		<< std::setw(12) << value / baseline << " x" << '\n';
+}
+
+template<class game_t>
+double measureRandomPlayouts() {
+	up<State> initialState = std::mku<game_t>();
+	auto start = std::chrono::high_resolution_clock::now();
+	int playouts = 0;
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		auto state = initialState->clone();
+		while (!state->isTerminal()) {
+			auto actions = state->getValidActions();
+			state->apply(Random::choice(actions));
+		}
+		++playouts;
+	}
+
+	return playouts * 1000.0 / getElapsedMs(start);
+}
+
+template<class game_t>
+double measureMoveMaskPlayouts() {
+	up<State> initialState = std::mku<game_t>();
+	auto start = std::chrono::high_resolution_clock::now();
+	int playouts = 0;
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		auto state = initialState->clone();
+		while (!state->isTerminal())
+			state->apply(Random::choice(state->getValidMovesMask()));
+		++playouts;
+	}
+
+	return playouts * 1000.0 / getElapsedMs(start);
+}
+
+template<class game_t>
+double measureMCTSAgent() {
+	up<State> initialState = std::mku<game_t>();
+	MCTSAgent agent(AGENT1, benchLimitInMs, initialState, {});
+	agent.getAction(initialState);
+	return agent.getAvgSimulationCount() * 1000.0 / benchLimitInMs;
+}
+
+void benchBitboard() {
+	double refPlayouts = measureRandomPlayouts<UltimateTicTacToe>();
+	double bitPlayouts = measureRandomPlayouts<BitboardUltimateTicTacToe>();
+	printResult("UltimateTicTacToe random playouts", refPlayouts, "playouts/sec");
+	printResult("BitboardUltimateTicTacToe random playouts", bitPlayouts, "playouts/sec");
+	printGain("Random playout gain", refPlayouts, bitPlayouts);
+
+	double refSims = measureMCTSAgent<UltimateTicTacToe>();
+	double bitSims = measureMCTSAgent<BitboardUltimateTicTacToe>();
+	printResult("UltimateTicTacToe MCTSAgent", refSims, "sim/sec");
+	printResult("BitboardUltimateTicTacToe MCTSAgent", bitSims, "sim/sec");
+	printGain("MCTSAgent gain", refSims, bitSims);
+}
+
+/* states differing in what the search sees, the reward only once the game is over */
+bool isSamePosition(State& reference, State& bitboard) {
+	if (reference.hash() != bitboard.hash() || reference.isTerminal() != bitboard.isTerminal() ||
+			reference.getTurn() != bitboard.getTurn())
+		return false;
+	if (reference.isTerminal())
+		return reference.getReward(AGENT1) == bitboard.getReward(AGENT1);
+	const auto referenceMoves = reference.getValidMovesMask(), bitboardMoves = bitboard.getValidMovesMask();
+	if (referenceMoves.count() != bitboardMoves.count())
+		return false;
+	for (const auto move : referenceMoves)
+		if (!bitboardMoves.test(move))
+			return false;
+	return true;
+}
+
+/*
+ * Plays the same random games on the reference and the bitboard state,
+ * comparing them after every move and again on the way back with undo,
+ * where they also have to match the hashes they had on the way down.
+ */
+void benchVerify() {
+	long long games = 0, positions = 0, mismatches = 0;
+	std::vector<PlayedMove> playedMoves;
+	std::vector<std::uint64_t> hashes;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		UltimateTicTacToe reference;
+		BitboardUltimateTicTacToe bitboard;
+		playedMoves.clear();
+		hashes.clear();
+		bool same = isSamePosition(reference, bitboard);
+		while (same && !reference.isTerminal()) {
+			const auto move = Random::choice(reference.getValidMovesMask());
+			hashes.push_back(reference.hash());
+			playedMoves.push_back({ move, reference.getUndoInfo() });
+			same = reference.getUndoInfo() == bitboard.getUndoInfo();
+			reference.apply(move);
+			bitboard.apply(move);
+			same = same && isSamePosition(reference, bitboard);
+			++positions;
+		}
+		for (; same && !playedMoves.empty(); playedMoves.pop_back(), hashes.pop_back()) {
+			reference.undo(playedMoves.back().move, playedMoves.back().undoInfo);
+			bitboard.undo(playedMoves.back().move, playedMoves.back().undoInfo);
+			same = isSamePosition(reference, bitboard) && bitboard.hash() == hashes.back();
+			++positions;
+		}
+		mismatches += !same;
+		++games;
+	}
+
+	printResult("Random games", games, "games");
+	printResult("Positions compared", positions, "positions");
+	printResult("Games with a mismatch", mismatches, "games");
+	failedCheckCount += mismatches;
+}
+
+template<class game_t>
+void benchMoveApiFor(const std::string& name) {
+	double actionPlayouts = measureRandomPlayouts<game_t>();
+	double maskPlayouts = measureMoveMaskPlayouts<game_t>();
+	printResult(name + " getValidActions playouts", actionPlayouts, "playouts/sec");
+	printResult(name + " getValidMovesMask playouts", maskPlayouts, "playouts/sec");
+	printGain(name + " gain", actionPlayouts, maskPlayouts);
+}
+
+void benchMoveApi() {
+	benchMoveApiFor<UltimateTicTacToe>("Reference");
+	benchMoveApiFor<BitboardUltimateTicTacToe>("Bitboard");
+}
+
+struct SearchMeasurement {
+	double simsPerSec;
+	double allocationsPerSim;
+};
+
+template<class agent_t, class game_t=BitboardUltimateTicTacToe>
+SearchMeasurement measureSearch(const Agent::AgentArgs& args) {
+	up<State> initialState = std::mku<game_t>();
+	agent_t agent(AGENT1, benchLimitInMs, initialState, args);
+
+	long long allocationsBefore = allocationCount;
+	agent.getAction(initialState);
+	double sims = agent.getAvgSimulationCount();
+
+	return { sims * 1000.0 / benchLimitInMs, (allocationCount - allocationsBefore) / sims };
+}
+
+template<class agent_t>
+void benchUndoFor(const std::string& name) {
+	auto cloneSearch = measureSearch<agent_t>({ { "undoSearch", 0 } });
+	auto undoSearch = measureSearch<agent_t>({ { "undoSearch", 1 } });
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "   " << std::left << std::setw(40) << name + " allocations/sim" << std::right
+		<< std::setw(12) << cloneSearch.allocationsPerSim << " -> "
+		<< undoSearch.allocationsPerSim << '\n';
+	printResult(name + " clone search", cloneSearch.simsPerSec, "sim/sec");
+	printResult(name + " undo search", undoSearch.simsPerSec, "sim/sec");
+	printGain(name + " gain", cloneSearch.simsPerSec, undoSearch.simsPerSec);
+}
+
+void benchUndo() {
+	benchUndoFor<MCTSAgent>("MCTSAgent");
+	benchUndoFor<FlatMCTSAgent>("FlatMCTSAgent");
+}
+
+double measureBatchPlayouts(int batchSize) {
+	BitboardUltimateTicTacToe initialState;
+	State::reward_t rewardSums[2] = {};
+	auto start = std::chrono::high_resolution_clock::now();
+	long long playouts = 0;
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		initialState.randomPlayouts(batchSize, rewardSums);
+		playouts += batchSize;
+	}
+
+	return playouts * 1000.0 / getElapsedMs(start);
+}
+
+template<class agent_t>
+void benchBatchSearchFor(const std::string& name) {
+	auto scalarSearch = measureSearch<agent_t>({ { "undoSearch", 1 } });
+	auto batchSearch = measureSearch<agent_t>({ { "undoSearch", 1 }, { "batchPlayouts", 16 } });
+	printResult(name + " scalar defaultPolicy", scalarSearch.simsPerSec, "playouts/sec");
+	printResult(name + " 16 playouts per leaf", batchSearch.simsPerSec, "playouts/sec");
+	printGain(name + " gain", scalarSearch.simsPerSec, batchSearch.simsPerSec);
+}
+
+void benchBatch() {
+	std::cout << "   Batch kernel: " << BitboardBatchRollout::getKernelName() << "\n\n";
+
+	double scalarPlayouts = measureMoveMaskPlayouts<BitboardUltimateTicTacToe>();
+	printResult("Scalar playouts", scalarPlayouts, "playouts/sec");
+	for (int batchSize : { 4, 16, 64 }) {
+		double batchPlayouts = measureBatchPlayouts(batchSize);
+		printResult("Batch playouts, " + std::to_string(batchSize) + " per call", batchPlayouts, "playouts/sec");
+		printGain("Batch playout gain", scalarPlayouts, batchPlayouts);
+	}
+
+	benchBatchSearchFor<MCTSAgent>("MCTSAgent");
+	benchBatchSearchFor<FlatMCTSAgent>("FlatMCTSAgent");
+}
+
+struct RolloutMeasurement {
+	double playoutsPerSec;
+	double averageLength;
+};
+
+template<class game_t>
+RolloutMeasurement measureRollouts(bool stopWhenDecided, int openingLength) {
+	up<State> initialState = std::mku<game_t>();
+	std::vector<up<State>> positions;
+	while (int(positions.size()) < 64) {
+		auto state = initialState->clone();
+		for (int i = 0; i < openingLength && !state->isDecided(); ++i)
+			state->apply(Random::choice(state->getValidMovesMask()));
+		if (!state->isDecided())
+			positions.push_back(std::move(state));
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	long long playouts = 0, plies = 0;
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		auto state = positions[playouts % positions.size()]->clone();
+		while (stopWhenDecided ? !state->isDecided() : !state->isTerminal()) {
+			state->apply(Random::choice(state->getValidMovesMask()));
+			++plies;
+		}
+		++playouts;
+	}
+
+	return { playouts * 1000.0 / getElapsedMs(start), double(plies) / playouts };
+}
+
+template<class game_t>
+void benchEarlyTerminationFor(const std::string& name, int openingLength) {
+	auto toTerminal = measureRollouts<game_t>(false, openingLength);
+	auto toDecided = measureRollouts<game_t>(true, openingLength);
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "   " << std::left << std::setw(40) << name + " rollout length" << std::right
+		<< std::setw(12) << toTerminal.averageLength << " -> " << toDecided.averageLength << " plies\n";
+	printResult(name + " until terminal", toTerminal.playoutsPerSec, "playouts/sec");
+	printResult(name + " until decided", toDecided.playoutsPerSec, "playouts/sec");
+	printGain(name + " gain", toTerminal.playoutsPerSec, toDecided.playoutsPerSec);
+}
+
+void benchEarlyTermination() {
+	benchEarlyTerminationFor<BitboardUltimateTicTacToe>("3x3 from start", 0);
+	benchEarlyTerminationFor<BitboardUltimateTicTacToe>("3x3 after 40 plies", 40);
+	benchEarlyTerminationFor<Bitboard4UltimateTicTacToe>("4x4 from start", 0);
+	benchEarlyTerminationFor<Bitboard4UltimateTicTacToe>("4x4 after 150 plies", 150);
+	printResult("MCTSAgent", measureSearch<MCTSAgent>({ { "undoSearch", 1 } }).simsPerSec, "sim/sec");
+}
+
+template<class draw_t>
+double measureBoundedDraws(draw_t draw) {
+	auto start = std::chrono::high_resolution_clock::now();
+	long long draws = 0;
+	unsigned checksum = 0;
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		for (int i = 0; i < 4096; ++i)
+			checksum += draw(1 + (i & 63));
+		draws += 4096;
+	}
+
+	if (checksum == 1)
+		std::cout << "";
+	return draws * 1000.0 / getElapsedMs(start);
+}
+
+template<class generator_t>
+double measureShuffles(generator_t& generator) {
+	std::vector<int> values(81);
+	auto start = std::chrono::high_resolution_clock::now();
+	long long shuffles = 0;
+
+	while (getElapsedMs(start) < benchLimitInMs) {
+		std::shuffle(values.begin(), values.end(), generator);
+		++shuffles;
+	}
+
+	return shuffles * 1000.0 / getElapsedMs(start);
+}
+
+void benchRandom() {
+	std::mt19937 mt(Random::DEFAULT_SEED);
+	double mtDraws = measureBoundedDraws([&mt](int n) {
+		return std::uniform_int_distribution<int>{0, n - 1}(mt);
+	});
+	double fastDraws = measureBoundedDraws([](int n) { return Random::rand(n); });
+	printResult("mt19937 + uniform_int_distribution", mtDraws, "draws/sec");
+	printResult("xoshiro256** + bounded", fastDraws, "draws/sec");
+	printGain("Bounded draw gain", mtDraws, fastDraws);
+
+	double mtShuffles = measureShuffles(mt);
+	double fastShuffles = measureShuffles(Random::rng);
+	printResult("mt19937 shuffle of 81 actions", mtShuffles, "shuffles/sec");
+	printResult("xoshiro256** shuffle of 81 actions", fastShuffles, "shuffles/sec");
+	printGain("Shuffle gain", mtShuffles, fastShuffles);
+}
+
+template<class game_t>
+void benchStaticFor(const std::string& name) {
+	auto virtualSearch = measureSearch<MCTSAgent, game_t>({ { "undoSearch", 1 } });
+	auto staticSearch = measureSearch<StaticMCTSAgent<game_t>, game_t>({});
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "   " << std::left << std::setw(40) << name + " allocations/sim" << std::right
+		<< std::setw(12) << virtualSearch.allocationsPerSim << " -> "
+		<< staticSearch.allocationsPerSim << '\n';
+	printResult(name + " MCTSAgent (virtual)", virtualSearch.simsPerSec, "sim/sec");
+	printResult(name + " StaticMCTSAgent", staticSearch.simsPerSec, "sim/sec");
+	printGain(name + " gain", virtualSearch.simsPerSec, staticSearch.simsPerSec);
+}
+
+void benchStatic() {
+	benchStaticFor<BitboardUltimateTicTacToe>("3x3");
+	benchStaticFor<Bitboard4UltimateTicTacToe>("4x4");
+}
+
+struct TreeMeasurement {
+	double simsPerSec;
+	double nodesPerSec;
+	double bytesPerNode;
+	double backupNs;
+	double backupDepth;
+};
+
+/* exposes backup, so it can be timed on the deepest path of a searched tree */
+class BackupProbe : public MCTSAgent {
+public:
+	using MCTSAgent::MCTSAgent;
+
+	TreeMeasurement measureTree(const up<State>& initialState) {
+		long long bytesBefore = allocatedBytes;
+		getAction(initialState);
+		TreeMeasurement result;
+		result.simsPerSec = getAvgSimulationCount() * 1000.0 / benchLimitInMs;
+		result.nodesPerSec = getNodeCount() * 1000.0 / benchLimitInMs;
+		result.bytesPerNode = double(allocatedBytes - bytesBefore) / getNodeCount();
+
+		index_t leaf = root;
+		int leafDepth = 0;
+		for (index_t i = 0; i < nodes.size(); ++i) {
+			int depth = 0;
+			for (index_t v = i; nodes[v].parent != NO_NODE; v = nodes[v].parent)
+				++depth;
+			if (nodeVisits[i] && depth > leafDepth)
+				leaf = i, leafDepth = depth;
+		}
+
+		descentPath.assign(leafDepth + 1, NO_NODE);
+		for (index_t v = leaf, depth = leafDepth; v != NO_NODE; v = nodes[v].parent)
+			descentPath[depth--] = v;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		long long backups = 0;
+		while (getElapsedMs(start) < benchLimitInMs) {
+			for (int i = 0; i < 1024; ++i) {
+				timesTreeDescended = leafDepth;
+				backup(leaf);
+			}
+			backups += 1024;
+		}
+		result.backupNs = getElapsedMs(start) * 1e6 / backups;
+		result.backupDepth = leafDepth + 1;
+		return result;
+	}
+};
+
+template<class game_t>
+void benchArenaFor(const std::string& name, const Agent::AgentArgs& args) {
+	up<State> initialState = std::mku<game_t>();
+	BackupProbe agent(AGENT1, benchLimitInMs, initialState, args);
+	auto tree = agent.measureTree(initialState);
+	printResult(name + " search", tree.simsPerSec, "sim/sec");
+	printResult(name + " nodes", tree.nodesPerSec, "nodes/sec");
+	printResult(name + " heap", tree.bytesPerNode, "bytes/node");
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "   " << std::left << std::setw(40) << name + " backup" << std::right
+		<< std::setw(12) << tree.backupNs << " ns (" << tree.backupDepth << " levels)\n";
+}
+
+void benchArena() {
+	benchArenaFor<UltimateTicTacToe>("Reference", {});
+	benchArenaFor<BitboardUltimateTicTacToe>("Bitboard", {});
+	benchArenaFor<BitboardUltimateTicTacToe>("Bitboard undo", { { "undoSearch", 1 } });
+}
+
+std::size_t getHeapInUse() {
+	const auto info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+}
+
+/* expands all children of the root and one grandchild under each, then frees them */
+class ExpansionProbe : public MCTSAgent {
+public:
+	using MCTSAgent::MCTSAgent;
+
+	double measureExpansions() {
+		auto start = std::chrono::high_resolution_clock::now();
+		long long expansions = 0;
+
+		while (getElapsedMs(start) < benchLimitInMs) {
+			while (nodes[root].shouldExpand()) {
+				const index_t child = expandGetIdx(root);
+				++expansions;
+				if (!nodes[child].isTerminal())
+					expandGetIdx(child), ++expansions;
+			}
+			auto rootState = nodes[root].cloneState();
+			releaseSubtree(root);
+			nodes[root].state = std::move(rootState);
+		}
+
+		return expansions * 1000.0 / getElapsedMs(start);
+	}
+};
+
+template<class game_t>
+void benchExpandFor(const std::string& name) {
+	up<State> initialState = std::mku<game_t>();
+	ExpansionProbe agent(AGENT1, benchLimitInMs, initialState, {});
+	const double expansions = agent.measureExpansions();
+	printResult(name + " expansions", expansions, "nodes/sec");
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "   " << std::left << std::setw(40) << name + " expansion" << std::right
+		<< std::setw(12) << 1e9 / expansions << " ns\n";
+}
+
+void benchExpand() {
+	benchExpandFor<UltimateTicTacToe>("Reference");
+	benchExpandFor<BitboardUltimateTicTacToe>("Bitboard");
+	benchExpandFor<Bitboard4UltimateTicTacToe>("Bitboard 4x4");
+}
+
+struct MemoryMeasurement {
+	double simsPerSec;
+	double bytesPerNode;
+	double nodesInBudget;
+};
+
+/* live heap of a searched tree per expanded node, the arena storage may be reused from a previous agent */
+template<class agent_t>
+class MemoryProbe : public agent_t {
+public:
+	using agent_t::agent_t;
+
+	MemoryMeasurement measureMemory(const up<State>& initialState, std::size_t heapBefore) {
+		const double reusedBytes = this->nodes.capacity() * sizeof(this->nodes[0]);
+		this->getAction(initialState);
+		const double treeBytes = getHeapInUse() - heapBefore + reusedBytes;
+
+		int expandedCount = 0;
+		for (const auto visits : this->nodeVisits)
+			expandedCount += visits > 0;
+
+		MemoryMeasurement result;
+		result.simsPerSec = this->getAvgSimulationCount() * 1000.0 / benchLimitInMs;
+		result.bytesPerNode = treeBytes / expandedCount;
+		result.nodesInBudget = rssBudgetInMb * (1 << 20) / result.bytesPerNode;
+		return result;
+	}
+};
+
+template<class agent_t>
+MemoryMeasurement measureMemory(const Agent::AgentArgs& args) {
+	up<State> initialState = std::mku<BitboardUltimateTicTacToe>();
+	const std::size_t heapBefore = getHeapInUse();
+	MemoryProbe<agent_t> agent(AGENT1, benchLimitInMs, initialState, args);
+	return agent.measureMemory(initialState, heapBefore);
+}
+
+template<class agent_t>
+void benchStatelessFor(const std::string& name) {
+	auto stateful = measureMemory<agent_t>({ { "undoSearch", 1 } });
+	auto stateless = measureMemory<agent_t>({ { "statelessNodes", 1 } });
+	std::cout << std::fixed << std::setprecision(0);
+	std::cout << "   " << std::left << std::setw(40) << name + " heap per expanded node" << std::right
+		<< std::setw(12) << stateful.bytesPerNode << " -> " << stateless.bytesPerNode << " bytes\n";
+	std::cout << "   " << std::left << std::setw(40) << name + " nodes in " + std::to_string(int(rssBudgetInMb)) + " MB"
+		<< std::right << std::setw(12) << stateful.nodesInBudget << " -> " << stateless.nodesInBudget << '\n';
+	printResult(name + " nodes with states", stateful.simsPerSec, "sim/sec");
+	printResult(name + " state-less nodes", stateless.simsPerSec, "sim/sec");
+	printGain(name + " gain", stateful.simsPerSec, stateless.simsPerSec);
+}
+
+void benchStateless() {
+	benchStatelessFor<MCTSAgent>("MCTSAgent");
+	benchStatelessFor<MCTSAgentWithRAVE>("MCTSAgentWithRAVE");
+}
+
+struct ReRootMeasurement {
+	double simsPerSec;
+	double averageMs;
+	double maxMs;
+};
+
+/* one agent plays both sides for a few moves, so every recordAction re-roots a searched tree */
+template<class game_t>
+ReRootMeasurement measureReRoot(const Agent::AgentArgs& args) {
+	constexpr int moveCount = 10;
+	up<State> state = std::mku<game_t>();
+	MCTSAgent agent(AGENT1, benchLimitInMs / moveCount, state, args);
+
+	double maxMs = 0;
+	for (int i = 0; i < moveCount && !state->isTerminal(); ++i) {
+		const auto action = agent.getAction(state);
+		auto start = std::chrono::high_resolution_clock::now();
+		agent.recordAction(action);
+		maxMs = std::max(maxMs, getElapsedMs(start));
+		state->apply(action);
+	}
+
+	const double simsPerSec = agent.getAvgSimulationCount() * moveCount * 1000.0 / benchLimitInMs;
+	return { simsPerSec, agent.getAverageReRootTime(), maxMs };
+}
+
+template<class game_t>
+void benchReRootFor(const std::string& name) {
+	auto synchronous = measureReRoot<game_t>({ { "reclaimBudget", 0 } });
+	auto deferred = measureReRoot<game_t>({});
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "   " << std::left << std::setw(40) << name + " average re-root" << std::right
+		<< std::setw(12) << synchronous.averageMs << " -> " << deferred.averageMs << " ms\n";
+	std::cout << "   " << std::left << std::setw(40) << name + " max re-root" << std::right
+		<< std::setw(12) << synchronous.maxMs << " -> " << deferred.maxMs << " ms\n";
+	printResult(name + " synchronous", synchronous.simsPerSec, "sim/sec");
+	printResult(name + " deferred", deferred.simsPerSec, "sim/sec");
+	printGain(name + " gain", synchronous.simsPerSec, deferred.simsPerSec);
+}
+
+void benchReRoot() {
+	benchReRootFor<BitboardUltimateTicTacToe>("Bitboard");
+	benchReRootFor<Bitboard4UltimateTicTacToe>("Bitboard 4x4");
+}
+
+struct BudgetMeasurement {
+	double score;
+	double simsPerSec;
+	int peakNodes;
+	int arenaNodes;
+	int evictedSubtrees;
+};
+
+/* a budgeted MCTSAgent plays against an unbounded one at a fixed turn time, sides alternate */
+template<class game_t>
+BudgetMeasurement measureBudget(int nodeBudget) {
+	constexpr int gameCount = 20;
+	const double turnLimitInMs = benchLimitInMs / 100;
+	BudgetMeasurement result { 0, 0, 0, 0, 0 };
+
+	for (int game = 0; game < gameCount; ++game) {
+		up<State> state = std::mku<game_t>();
+		const AgentID budgetedID = game % 2 ? AGENT2 : AGENT1;
+		MCTSAgent budgeted(budgetedID, turnLimitInMs, state, { { "nodeBudget", nodeBudget } });
+		MCTSAgent unbounded(AgentID(budgetedID ^ 1), turnLimitInMs, state, {});
+
+		while (!state->isTerminal()) {
+			auto& agent = state->getTurn() == budgetedID ? budgeted : unbounded;
+			const auto action = agent.getAction(state);
+			budgeted.recordAction(action);
+			unbounded.recordAction(action);
+			state->apply(action);
+		}
+
+		result.score += state->getReward(budgetedID) / gameCount;
+		result.simsPerSec += budgeted.getAvgSimulationCount() * 1000.0 / turnLimitInMs / gameCount;
+		result.peakNodes = std::max(result.peakNodes, budgeted.getPeakNodeCount());
+		result.arenaNodes = std::max(result.arenaNodes, budgeted.getNodeCount());
+		result.evictedSubtrees += budgeted.getEvictedSubtreeCount();
+	}
+
+	return result;
+}
+
+void benchBudgetFor(int nodeBudget) {
+	const auto result = measureBudget<BitboardUltimateTicTacToe>(nodeBudget);
+	const std::string name = nodeBudget ? std::to_string(nodeBudget) + " node budget" : "No budget";
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "   " << std::left << std::setw(40) << name + " score" << std::right
+		<< std::setw(12) << result.score << '\n';
+	printResult(name + " search", result.simsPerSec, "sim/sec");
+	printResult(name + " peak tree", result.peakNodes, "nodes");
+	printResult(name + " arena", result.arenaNodes, "nodes");
+	printResult(name + " evicted", result.evictedSubtrees, "subtrees");
+}
+
+void benchBudget() {
+	for (const int nodeBudget : { 0, 65536, 16384, 4096 })
+		benchBudgetFor(nodeBudget);
+}
+
+/* sim/sec of AGENT1 in the turns after its first one, both agents compact their trees or neither */
+template<class game_t>
+double measureReusedTreeSearch(const Agent::AgentArgs& args) {
+	constexpr int moveCount = 20;
+	const double turnLimitInMs = benchLimitInMs / 10;
+	up<State> state = std::mku<game_t>();
+	MCTSAgent agents[] {
+		MCTSAgent(AGENT1, turnLimitInMs, state, args),
+		MCTSAgent(AGENT2, turnLimitInMs, state, args)
+	};
+
+	double firstTurnSims = 0;
+	int turns = 0;
+	for (int i = 0; i < moveCount && !state->isTerminal(); ++i) {
+		auto& agent = agents[state->getTurn()];
+		const auto action = agent.getAction(state);
+		if (state->getTurn() == AGENT1 && turns++ == 0)
+			firstTurnSims = agent.getAvgSimulationCount();
+		for (auto& a : agents)
+			a.recordAction(action);
+		state->apply(action);
+	}
+
+	const double laterSims = agents[AGENT1].getAvgSimulationCount() * turns - firstTurnSims;
+	return laterSims * 1000.0 / (turnLimitInMs * (turns - 1));
+}
+
+template<class game_t>
+void benchCompactFor(const std::string& name, Agent::AgentArgs args) {
+	const double scattered = measureReusedTreeSearch<game_t>(args);
+	args["compactTree"] = 1;
+	const double compacted = measureReusedTreeSearch<game_t>(args);
+	printResult(name + " scattered tree", scattered, "sim/sec");
+	printResult(name + " compacted tree", compacted, "sim/sec");
+	printGain(name + " gain", scattered, compacted);
+}
+
+void benchCompact() {
+	benchCompactFor<UltimateTicTacToe>("Reference", {});
+	benchCompactFor<BitboardUltimateTicTacToe>("Bitboard", {});
+	benchCompactFor<BitboardUltimateTicTacToe>("Bitboard state-less", { { "statelessNodes", 1 } });
+}
+
+/* runs a fixed number of iterations, so agents compared build trees of the same size */
+template<class agent_t>
+class IterationProbe : public agent_t {
+public:
+	using agent_t::agent_t;
+
+	MemoryMeasurement measureIterations(int iterationCount, std::size_t heapBefore) {
+		if (this->undoSearch)
+			this->searchState = this->nodes[this->root].cloneState();
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterationCount; ++i) {
+			const auto selectedNode = this->treePolicy();
+			this->defaultPolicy(selectedNode);
+			this->backup(selectedNode);
+			this->endRollout();
+		}
+		const double elapsedMs = getElapsedMs(start);
+
+		int expandedCount = 0;
+		for (const auto visits : this->nodeVisits)
+			expandedCount += visits > 0;
+
+		MemoryMeasurement result;
+		result.simsPerSec = iterationCount * 1000.0 / elapsedMs;
+		result.bytesPerNode = double(getHeapInUse() - heapBefore) / expandedCount;
+		result.nodesInBudget = rssBudgetInMb * (1 << 20) / result.bytesPerNode;
+		return result;
+	}
+};
+
+template<class agent_t, class game_t>
+void benchAMAFFor(const std::string& name, int iterationCount) {
+	for (const int raveMinVisits : { 1, 4, 16 }) {
+		up<State> initialState = std::mku<game_t>();
+		const std::size_t heapBefore = getHeapInUse();
+		IterationProbe<agent_t> agent(AGENT1, benchLimitInMs, initialState,
+			{ { "undoSearch", 1 }, { "raveMinVisits", raveMinVisits } });
+		const auto result = agent.measureIterations(iterationCount, heapBefore);
+		const std::string label = name + " AMAF from " + std::to_string(raveMinVisits);
+		printResult(label + " search", result.simsPerSec, "sim/sec");
+		printResult(label + " heap", result.bytesPerNode, "bytes/node");
+	}
+}
+
+void benchAMAF() {
+	benchAMAFFor<MCTSAgentWithRAVE, BitboardUltimateTicTacToe>("RAVE", 50000);
+	benchAMAFFor<MCTSAgentWithRAVE, Bitboard4UltimateTicTacToe>("RAVE 4x4", 20000);
+}
+
+/* the root with all children expanded and random statistics, selected from again and again */
+class SelectProbe : public MCTSAgent {
+public:
+	SelectProbe(const up<State>& initialState) :
+		MCTSAgent(AGENT1, benchLimitInMs, initialState, {}) {
+		while (nodes[root].shouldExpand())
+			expandGetIdx(root);
+		const auto& rootNode = nodes[root];
+		for (index_t i = rootNode.firstChild; i < rootNode.firstChild + rootNode.expandedCount; ++i) {
+			nodeVisits[i] = 1 + Random::rand(1000);
+			nodeScores[i] = Random::rand(nodeVisits[i] + 1);
+			nodeVisits[root] += nodeVisits[i];
+			blendWeights.push_back(Random::rand(2) ? 0.25 : 0);
+			blendValues.push_back(Random::rand(101) / 100.0);
+		}
+	}
+
+	int getChildCount() const {
+		return nodes[root].expandedCount;
+	}
+
+	double measureSelections(bool virtualEval, bool simd, bool blend) {
+		simdSelect = simd;
+		auto start = std::chrono::high_resolution_clock::now();
+		long long selections = 0;
+		index_t checksum = 0;
+
+		while (getElapsedMs(start) < benchLimitInMs) {
+			for (int i = 0; i < 1000; ++i)
+				checksum += virtualEval ? selectGetIdx(root) : blend ?
+					selectUCT(root, 0.4, blendWeights.data(), blendValues.data()) :
+					selectUCT(root, 0.4);
+			selections += 1000;
+		}
+
+		if (checksum == NO_NODE)
+			std::cout << "";
+		return selections * 1000.0 / getElapsedMs(start);
+	}
+
+private:
+	std::vector<param_t> blendWeights;
+	std::vector<param_t> blendValues;
+};
+
+void benchSelect() {
+	up<State> initialState = std::mku<BitboardUltimateTicTacToe>();
+	SelectProbe agent(initialState);
+	const std::string children = " over " + std::to_string(agent.getChildCount()) + " children";
+
+	const double virtualEval = agent.measureSelections(true, false, false);
+	const double scalar = agent.measureSelections(false, false, false);
+	const double simd = agent.measureSelections(false, true, false);
+	printResult("Virtual eval" + children, virtualEval, "selections/sec");
+	printResult("Scalar UCT" + children, scalar, "selections/sec");
+	printResult("AVX2 UCT" + children, simd, "selections/sec");
+	printGain("Scalar UCT gain", virtualEval, scalar);
+	printGain("AVX2 UCT gain", scalar, simd);
+
+	const double blendedScalar = agent.measureSelections(false, false, true);
+	const double blendedSimd = agent.measureSelections(false, true, true);
+	printResult("Scalar RAVE blend" + children, blendedScalar, "selections/sec");
+	printResult("AVX2 RAVE blend" + children, blendedSimd, "selections/sec");
+	printGain("AVX2 RAVE blend gain", blendedScalar, blendedSimd);
+}
+
+struct PagedSearchMeasurement {
+	double simsPerSec;
+	std::string pages;
+};
+
+/* search of a fixed number of iterations, the tree grows far beyond what the TLB covers with small pages */
+template<class agent_t>
+PagedSearchMeasurement measurePagedSearch(Agent::AgentArgs args, int iterationCount) {
+	up<State> initialState = std::mku<BitboardUltimateTicTacToe>();
+	args["statelessNodes"] = 1;
+	IterationProbe<agent_t> agent(AGENT1, benchLimitInMs, initialState, args);
+	const double simsPerSec = agent.measureIterations(iterationCount, getHeapInUse()).simsPerSec;
+	return { simsPerSec, agent.getNodeStoragePages() };
+}
+
+template<class agent_t>
+void benchPagesFor(const std::string& name, int iterationCount) {
+	const double defaultPages = measurePagedSearch<agent_t>({}, iterationCount).simsPerSec;
+	printResult(name + " default pages", defaultPages, "sim/sec");
+	const std::pair<std::string, Agent::AgentArgs> configs[] {
+		{ "transparent", { { "hugePages", 1 } } },
+		{ "explicit", { { "hugePages", 2 } } },
+		{ "NUMA local", { { "numaLocal", 1 } } },
+		{ "transparent NUMA local", { { "hugePages", 1 }, { "numaLocal", 1 } } }
+	};
+	std::string explicitPages;
+	for (const auto& [label, args] : configs) {
+		const auto paged = measurePagedSearch<agent_t>(args, iterationCount);
+		printResult(name + " " + label, paged.simsPerSec, "sim/sec");
+		printGain(name + " " + label + " gain", defaultPages, paged.simsPerSec);
+		if (label == "explicit")
+			explicitPages = paged.pages;
+	}
+	std::cout << "   " << name << " explicit huge pages: " << explicitPages << '\n';
+}
+
+void benchPages() {
+	benchPagesFor<MCTSAgent>("MCTSAgent", 1000000);
+	benchPagesFor<MCTSAgentWithRAVE>("RAVE", 500000);
+}
+
+struct PrefetchMeasurement {
+	double simsPerSec;
+	std::string cacheMisses;
+	std::string l1Misses;
+};
+
+template<class agent_t>
+PrefetchMeasurement measurePrefetch(int prefetchDistance) {
+	up<State> initialState = std::mku<BitboardUltimateTicTacToe>();
+	agent_t agent(AGENT1, benchLimitInMs, initialState,
+		{ { "undoSearch", 1 }, { "prefetchDistance", prefetchDistance }, { "countCacheMisses", 1 } });
+	agent.getAction(initialState);
+	return { agent.getAvgSimulationCount() * 1000.0 / benchLimitInMs,
+		agent.getCacheMissesPerIteration(), agent.getL1MissesPerIteration() };
+}
+
+template<class agent_t>
+void benchPrefetchFor(const std::string& name) {
+	const auto baseline = measurePrefetch<agent_t>(0);
+	for (const int prefetchDistance : { 0, 1, 2, 4 }) {
+		const auto result = prefetchDistance ? measurePrefetch<agent_t>(prefetchDistance) : baseline;
+		const std::string label = name + " prefetch " + std::to_string(prefetchDistance);
+		printResult(label, result.simsPerSec, "sim/sec");
+		std::cout << "   " << std::left << std::setw(40) << label + " misses/iter" << std::right
+			<< std::setw(12) << result.cacheMisses << " cache, " << result.l1Misses << " L1D\n";
+		if (prefetchDistance)
+			printGain(label + " gain", baseline.simsPerSec, result.simsPerSec);
+	}
+}
+
+void benchPrefetch() {
+	benchPrefetchFor<MCTSAgent>("MCTSAgent");
+	benchPrefetchFor<MCTSAgentWithRAVE>("RAVE");
+}
+
+template<class agent_t>
+void benchThreadsFor(const std::string& name) {
+	double singleThread = 0;
+	for (const int threads : { 1, 2, 4, 8 }) {
+		up<State> initialState = std::mku<BitboardUltimateTicTacToe>();
+		agent_t agent(AGENT1, benchLimitInMs, initialState, { { "undoSearch", 1 }, { "threads", threads } });
+		agent.getAction(initialState);
+		const double simsPerSec = agent.getAvgSimulationCount() * 1000.0 / benchLimitInMs;
+		const std::string label = name + " " + std::to_string(threads) + " threads";
+		printResult(label, simsPerSec, "sim/sec");
+		std::cout << "   " << label << " per thread: " << agent.getSimsPerSecPerThread() << '\n';
+		if (threads == 1)
+			singleThread = simsPerSec;
+		else
+			printGain(label + " gain", singleThread, simsPerSec);
+	}
+}
+
+void benchThreads() {
+	std::cout << "   " << std::thread::hardware_concurrency() << " hardware threads\n";
+	benchThreadsFor<MCTSAgent>("MCTSAgent");
+	benchThreadsFor<MCTSAgentWithRAVE>("RAVE");
+}
+
+struct TreeParallelMeasurement {
+	double simsPerSec;
+	double score;
+};
+
+/* sim/s of one turn, and the score against the single-threaded search over games at 1/100 of the limit */
+template<class game_t>
+TreeParallelMeasurement measureTreeParallel(int threads) {
+	using agent_t = TreeParallelMCTSAgent<game_t>;
+	constexpr int gameCount = 10;
+	const double turnLimitInMs = benchLimitInMs / 100;
+	TreeParallelMeasurement result { 0, 0 };
+
+	up<State> initialState = std::mku<game_t>();
+	agent_t searcher(AGENT1, benchLimitInMs, initialState, { { "threads", threads } });
+	searcher.getAction(initialState);
+	result.simsPerSec = searcher.getAvgSimulationCount() * 1000.0 / benchLimitInMs;
+
+	for (int game = 0; game < gameCount; ++game) {
+		up<State> state = std::mku<game_t>();
+		const AgentID parallelID = game % 2 ? AGENT2 : AGENT1;
+		agent_t parallel(parallelID, turnLimitInMs, state, { { "threads", threads } });
+		agent_t single(AgentID(parallelID ^ 1), turnLimitInMs, state, {});
+
+		while (!state->isTerminal()) {
+			auto& agent = state->getTurn() == parallelID ? parallel : single;
+			const auto action = agent.getAction(state);
+			parallel.recordAction(action);
+			single.recordAction(action);
+			state->apply(action);
+		}
+
+		result.score += state->getReward(parallelID) / gameCount;
+	}
+
+	return result;
+}
+
+void benchTreeParallel() {
+	std::cout << "   " << std::thread::hardware_concurrency() << " hardware threads\n";
+	double singleThread = 0;
+	for (const int threads : { 1, 2, 4, 8, 16, 32 }) {
+		const auto result = measureTreeParallel<BitboardUltimateTicTacToe>(threads);
+		const std::string label = "Shared tree " + std::to_string(threads) + " threads";
+		printResult(label, result.simsPerSec, "sim/sec");
+		if (threads == 1)
+			singleThread = result.simsPerSec;
+		else
+			printGain(label + " gain", singleThread, result.simsPerSec);
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "   " << std::left << std::setw(40) << label + " score" << std::right
+			<< std::setw(12) << result.score << '\n';
+	}
+}
+
+/* score of MCTSAgent with args against a single-threaded one playing one playout per leaf, at 1/100 of the limit */
+double measureScoreAgainstScalar(const Agent::AgentArgs& args) {
+	constexpr int gameCount = 10;
+	const double turnLimitInMs = benchLimitInMs / 100;
+	double score = 0;
+
+	for (int game = 0; game < gameCount; ++game) {
+		up<State> state = std::mku<BitboardUltimateTicTacToe>();
+		const AgentID measuredID = game % 2 ? AGENT2 : AGENT1;
+		MCTSAgent measured(measuredID, turnLimitInMs, state, args);
+		MCTSAgent scalar(AgentID(measuredID ^ 1), turnLimitInMs, state, { { "undoSearch", 1 } });
+
+		while (!state->isTerminal()) {
+			auto& agent = state->getTurn() == measuredID ? measured : scalar;
+			const auto action = agent.getAction(state);
+			measured.recordAction(action);
+			scalar.recordAction(action);
+			state->apply(action);
+		}
+
+		score += state->getReward(measuredID) / gameCount;
+	}
+
+	return score;
+}
+
+void benchLeafParallel() {
+	std::cout << "   " << std::thread::hardware_concurrency() << " hardware threads\n";
+	for (const int batchPlayouts : { 8, 32 }) {
+		double singleThread = 0;
+		for (const int leafThreads : { 0, 1, 3, 7 }) {
+			const Agent::AgentArgs args { { "undoSearch", 1 }, { "batchPlayouts", batchPlayouts },
+				{ "leafThreads", leafThreads } };
+			const auto search = measureSearch<MCTSAgent>(args);
+			const std::string label = std::to_string(batchPlayouts) + " playouts on "
+				+ std::to_string(leafThreads + 1) + " threads";
+			printResult(label, search.simsPerSec, "playouts/sec");
+			if (leafThreads == 0)
+				singleThread = search.simsPerSec;
+			else
+				printGain(label + " gain", singleThread, search.simsPerSec);
+			std::cout << std::fixed << std::setprecision(2);
+			std::cout << "   " << std::left << std::setw(40) << label + " score" << std::right
+				<< std::setw(12) << measureScoreAgainstScalar(args) << '\n';
+		}
+	}
+}
+
+/* a MAST table behind one lock, what sharing the plain per-agent vectors would take */
+class LockedMASTTable {
+public:
+	LockedMASTTable(int agentCount, int actionCount) :
+		actionCount(actionCount), scores(agentCount * actionCount), times(agentCount * actionCount) {
+
+	}
+
+	void addPlayout(const std::vector<std::pair<AgentID, int>>& history, State::reward_t agent1Reward) {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& [id, actionIdx] : history) {
+			scores[id * actionCount + actionIdx] += id == AGENT1 ? agent1Reward : 1 - agent1Reward;
+			++times[id * actionCount + actionIdx];
+		}
+	}
+
+private:
+	int actionCount;
+	std::mutex mutex;
+	std::vector<State::reward_t> scores;
+	std::vector<long long> times;
+};
+
+/*
+ * Action updates/s of threads adding playouts of random moves to one shared
+ * table, through the lock (flushInterval 0) or through MASTTable flushed
+ * every flushInterval playouts.
+ */
+double measureMASTUpdates(int threadCount, int flushInterval) {
+	constexpr int playoutLength = 40;
+	const int actionCount = BitboardUltimateTicTacToe().getActionCount();
+	const auto limit = std::chrono::duration<double, std::milli>(benchLimitInMs / 10);
+	MASTTable table(2, actionCount);
+	table.share();
+	LockedMASTTable lockedTable(2, actionCount);
+	std::atomic<long long> updateCount { 0 };
+
+	const auto seed = Random::rng();
+	auto run = [&](int stream) {
+		Random::seed(seed, stream);
+		MASTTable::Updates updates(table);
+		std::vector<std::pair<AgentID, int>> history(playoutLength);
+		long long playouts = 0;
+		const auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < limit) {
+			for (int i = 0; i < playoutLength; ++i)
+				history[i] = { AgentID(i & 1), int(Random::rand(actionCount)) };
+			const State::reward_t agent1Reward = Random::rand(3) * 0.5;
+			if (flushInterval == 0)
+				lockedTable.addPlayout(history, agent1Reward);
+			else {
+				for (const auto& [id, actionIdx] : history)
+					updates.add(id, actionIdx, id == AGENT1 ? agent1Reward : 1 - agent1Reward);
+				if ((playouts + 1) % flushInterval == 0)
+					table.flush(updates);
+			}
+			++playouts;
+		}
+		table.flush(updates);
+		updateCount += playouts * playoutLength;
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; ++i)
+		threads.emplace_back(run, i);
+	run(0);
+	for (auto& thread : threads)
+		thread.join();
+
+	return updateCount / (benchLimitInMs / 10) * 1000;
+}
+
+void benchMAST() {
+	std::cout << "   " << std::thread::hardware_concurrency() << " hardware threads\n";
+	for (const int threads : { 1, 2, 4, 8, 16, 32 }) {
+		const std::string label = std::to_string(threads) + " threads";
+		const double locked = measureMASTUpdates(threads, 0);
+		printResult(label + " locked table", locked, "updates/sec");
+		for (const int flushInterval : { 1, 16 }) {
+			const double lockFree = measureMASTUpdates(threads, flushInterval);
+			const std::string name = label + " flush every " + std::to_string(flushInterval);
+			printResult(name, lockFree, "updates/sec");
+			printGain(name + " gain", locked, lockFree);
+		}
+	}
+}
+
+struct TranspositionMeasurement {
+	double score;
+	double transpositionShare;
+	double simsPerSec;
+	double nodesPerSec;
+	double treeSimsPerSec;
+};
+
+/* TranspositionMCTSAgent against StaticMCTSAgent over games at 1/100 of the limit */
+template<class game_t>
+TranspositionMeasurement measureTranspositions(int tableBits) {
+	constexpr int gameCount = 20;
+	const double turnLimitInMs = benchLimitInMs / 100;
+	TranspositionMeasurement result { 0, 0, 0, 0, 0 };
+
+	for (int game = 0; game < gameCount; ++game) {
+		up<State> state = std::mku<game_t>();
+		const AgentID graphID = game % 2 ? AGENT2 : AGENT1;
+		TranspositionMCTSAgent<game_t> graph(graphID, turnLimitInMs, state, { { "tableBits", tableBits } });
+		StaticMCTSAgent<game_t> tree(AgentID(graphID ^ 1), turnLimitInMs, state, {});
+
+		while (!state->isTerminal()) {
+			auto& agent = state->getTurn() == graphID ? static_cast<Agent&>(graph) : tree;
+			const auto action = agent.getAction(state);
+			graph.recordAction(action);
+			tree.recordAction(action);
+			state->apply(action);
+		}
+
+		result.score += state->getReward(graphID) / gameCount;
+		result.transpositionShare += graph.getAverageTranspositionShare() / gameCount;
+		result.simsPerSec += graph.getAvgSimulationCount() * 1000.0 / turnLimitInMs / gameCount;
+		result.nodesPerSec += graph.getNodesPerSec() / gameCount;
+		result.treeSimsPerSec += tree.getAvgSimulationCount() * 1000.0 / turnLimitInMs / gameCount;
+	}
+
+	return result;
+}
+
+void benchTranspositions() {
+	using game_t = BitboardUltimateTicTacToe;
+	const auto treeSearch = measureSearch<StaticMCTSAgent<game_t>>({});
+	const auto graphSearch = measureSearch<TranspositionMCTSAgent<game_t>>({});
+	printResult("Opening tree search", treeSearch.simsPerSec, "sim/sec");
+	printResult("Opening graph search", graphSearch.simsPerSec, "sim/sec");
+	printGain("Opening graph search gain", treeSearch.simsPerSec, graphSearch.simsPerSec);
+
+	for (const int tableBits : { 10, 16 }) {
+		const auto result = measureTranspositions<game_t>(tableBits);
+		const std::string name = std::to_string(4 << tableBits) + " table entries";
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "   " << std::left << std::setw(40) << name + " score" << std::right
+			<< std::setw(12) << result.score << '\n';
+		std::cout << "   " << std::left << std::setw(40) << name + " transpositions" << std::right
+			<< std::setw(12) << 100 * result.transpositionShare << " % of expansions per move\n";
+		printResult(name + " tree search", result.treeSimsPerSec, "sim/sec");
+		printResult(name + " graph search", result.simsPerSec, "sim/sec");
+		printResult(name + " new positions", result.nodesPerSec, "nodes/sec");
+		printGain(name + " sim/sec gain", result.treeSimsPerSec, result.simsPerSec);
+	}
+}
+
+void benchBoardSize() {
+	printResult("3x3 random playouts", measureMoveMaskPlayouts<BitboardUltimateTicTacToe>(), "playouts/sec");
+	printResult("4x4 random playouts", measureMoveMaskPlayouts<Bitboard4UltimateTicTacToe>(), "playouts/sec");
+	printResult("3x3 MCTSAgent", measureMCTSAgent<BitboardUltimateTicTacToe>(), "sim/sec");
+	printResult("4x4 MCTSAgent", measureMCTSAgent<Bitboard4UltimateTicTacToe>(), "sim/sec");
+}
+
+std::vector<Benchmark> benchmarks {
+	{ "bitboard", "reference vs bitboard UltimateTicTacToe state", benchBitboard },
+	{ "verify", "bitboard against reference UltimateTicTacToe in random games", benchVerify },
+	{ "moves", "sp<Action> vector vs move mask rollouts", benchMoveApi },
+	{ "undo", "cloned vs apply/undo search state", benchUndo },
+	{ "batch", "scalar vs lockstep batch random playouts", benchBatch },
+	{ "size", "3x3 vs 4x4 bitboard UltimateTicTacToe", benchBoardSize },
+	{ "early", "rollouts until terminal vs until the result is decided", benchEarlyTermination },
+	{ "random", "mt19937 vs thread-local xoshiro256** generator", benchRandom },
+	{ "static", "virtual MCTSAgent vs MCTS<game_t> core", benchStatic },
+	{ "arena", "MCTSAgentBase node arena growth and backup", benchArena },
+	{ "stateless", "tree nodes with a state vs move and statistics only", benchStateless },
+	{ "expand", "MCTSAgentBase node expansion", benchExpand },
+	{ "reroot", "synchronous vs deferred reclamation of discarded subtrees", benchReRoot },
+	{ "budget", "MCTSAgent with a node budget against an unbounded one", benchBudget },
+	{ "compact", "reused tree as allocated vs compacted breadth-first after every move", benchCompact },
+	{ "amaf", "RAVE search and heap at a fixed tree size by AMAF visit threshold", benchAMAF },
+	{ "select", "virtual eval vs scalar and AVX2 UCT argmax over the children", benchSelect },
+	{ "prefetch", "tree descent and backup with and without prefetching by distance", benchPrefetch },
+	{ "pages", "large trees on default, transparent and explicit huge pages", benchPages },
+	{ "threads", "root-parallel search on 1 to 8 threads", benchThreads },
+	{ "tree", "tree-parallel search with virtual loss on 1 to 32 threads", benchTreeParallel },
+	{ "leaf", "batched leaf playouts on the search thread vs a playout pool", benchLeafParallel },
+	{ "mast", "MAST table updates behind a lock vs lock-free on 1 to 32 threads", benchMAST },
+	{ "transposition", "MCTS<game_t> tree vs graph of positions joined by a transposition table",
+		benchTranspositions },
+};
+
+void parseArgs(int argc, char* argv[], std::vector<std::string>& selected) {
+	static const char helpstr[] =
+		"\nUsage: ultimate-tictactoe-bench [OPTIONS]... [BENCHMARK]...\n\n"
+		"Run selected (or all) benchmarks.\n\n"
+		"List of possible options:\n"
+		"\t-t, --time\ttime limit of a single measurement in ms\n"
+		"\t-m, --memory\tRSS budget in MB the tree sizes are reported for\n"
+		"\t-l, --list\tlist available benchmarks\n"
+		"\t-h, --help\tprint this help\n\n";
+
+	static option longopts[] {
+		{"time", required_argument, 0, 't'},
+		{"memory", required_argument, 0, 'm'},
+		{"list", no_argument, 0, 'l'},
+		{"help", no_argument, 0, 'h'}
+	};
+
+	int idx, opt;
+	while ((opt = getopt_long(argc, argv, "t:m:lh", longopts, &idx)) != -1) {
+		switch (opt) {
+			case 't':
+				benchLimitInMs = std::stod(optarg);
+				break;
+			case 'm':
+				rssBudgetInMb = std::stod(optarg);
+				break;
+			case 'l':
+				for (const auto& benchmark : benchmarks)
+					std::cout << benchmark.name << "\t" << benchmark.desc << '\n';
+				exit(EXIT_SUCCESS);
+			case 'h':
+				std::cout << helpstr;
+				exit(EXIT_SUCCESS);
+		}
+	}
+
+	for (int i = optind; i < argc; ++i)
+		selected.push_back(argv[i]);
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<std::string> selected;
+	parseArgs(argc, argv, selected);
+
+	for (const auto& benchmark : benchmarks) {
+		if (!selected.empty() &&
+			std::find(selected.begin(), selected.end(), benchmark.name) == selected.end())
+			continue;
+		std::cout << '\n' << benchmark.name << ": " << benchmark.desc << "\n\n";
+		benchmark.run();
+	}
+
+	return failedCheckCount ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -2,6 +2,7 @@
 #include "GameRunner.hpp"
 #include "CGRunner.hpp"
 #include "UltimateTicTacToe.hpp"
+#include "BitboardUltimateTicTacToe.hpp"
 #include "RandomAgent.hpp"
 #include "FlatMCTSAgent.hpp"
 #include "MCTSAgent.hpp"
@@ -16,6 +17,7 @@
 bool verboseFlag = false;
 int numberOfGames = 1;
 double turnLimitInMs = 100;
+std::uint64_t randomSeed = std::random_device{}();
 
 void parseArgs(int argc, char* argv[]) {
 	static const char helpstr[] =
@@ -23,19 +25,24 @@ void parseArgs(int argc, char* argv[]) {
 		"Run TIMES TicTacToe games.\n\n"
 		"List of possible options:\n"
 		"\t-v, --verbose\tprint the game\n"
+		"\t-s, --seed\tseed of the random generators (reproducible games)\n"
 		"\t-h, --help\tprint this help\n\n";
 
 	static option longopts[] {
 		{"verbose", no_argument, 0, 'v'},
+		{"seed", required_argument, 0, 's'},
 		{"help", no_argument, 0, 'h'}
 	};
 
 	int idx, opt;
-	while ((opt = getopt_long(argc, argv, "vh", longopts, &idx)) != -1) {
+	while ((opt = getopt_long(argc, argv, "vs:h", longopts, &idx)) != -1) {
 		switch (opt) {
 			case 'v':
 				verboseFlag = true;
 				break;
+			case 's':
+				randomSeed = std::stoull(optarg);
+				break;
 			case 'h':
 				std::cout << helpstr;
 				exit(EXIT_SUCCESS);
@@ -57,29 +64,34 @@ int main(int argc, char* argv[]) {
 
 #ifdef LOCAL
 	parseArgs(argc, argv);
-	auto gameRunner = GameRunner<UltimateTicTacToe, MCTSAgentWithMASTAndRAVE, MCTSAgentWithMASTAndRAVE>(
+	auto gameRunner = GameRunner<BitboardUltimateTicTacToe, MCTSAgentWithMASTAndRAVE, MCTSAgentWithMASTAndRAVE>(
 		turnLimitInMs, {
 				{ "exploreFactor", 0.4 },
 				{ "epsilon", 0.8 },
 				{ "decayFactor", 0.6 },
-				{ "KFactor", 50.0 }
+				{ "KFactor", 50.0 },
+				{ "undoSearch", 1 }
 			}, {
 				{ "exploreFactor", 0.4 },
 				{ "epsilon", 0.8 },
 				{ "decayFactor", 0.6 },
-				{ "KFactor", 50.0 }
+				{ "KFactor", 50.0 },
+				{ "undoSearch", 1 }
 			}
 	);
+	gameRunner.setSeed(randomSeed);
 	gameRunner.playGames(numberOfGames, verboseFlag);
 #else
-	auto cgRunner = CGRunner<UltimateTicTacToe, MCTSAgentWithRAVE>(
+	auto cgRunner = CGRunner<BitboardUltimateTicTacToe, MCTSAgentWithRAVE>(
 		turnLimitInMs, {
 			{ "exploreFactor", 0.4 },
 			{ "epsilon", 0.8 },
 			{ "decayFactor", 0.6 },
-			{ "KFactor", 50.0 }
+			{ "KFactor", 50.0 },
+			{ "undoSearch", 1 }
 		}
 	);
+	Random::seed(randomSeed);
 	cgRunner.playGame();
 #endif
 